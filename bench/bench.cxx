@@ -0,0 +1,418 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../include/miniXML/batch.hpp"
+#include "../include/miniXML/compact_document.hpp"
+#include "../include/miniXML/diff.hpp"
+#include "corpus.hpp"
+
+#if defined(_WIN32)
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+// Benchmark suite, prints one JSON document with a result per operation, corpus shape and size.
+// Usage: miniXML_bench [--sizes=1M,16M] [--shapes=deep,wide,...] [--repeat=3] [--engines=tokens,direct,parallel,lazy] [--out=file.json]
+using namespace miniXML;
+using namespace miniXML::details;
+
+namespace{
+    std::atomic<std::size_t> allocationCount{0};
+    std::atomic<std::size_t> allocatedBytes{0};
+}
+
+void* operator new(const std::size_t size){
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if(void* p = std::malloc(size ? size : 1)){
+        return p;
+    }
+    throw std::bad_alloc();
+}
+// GCC inlines this into callers and then reports free() on a pointer from a new expression, which here comes from malloc()
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+// the other forms go through the two above, so every allocation is released by the function that matches it
+void operator delete(void* p, std::size_t) noexcept {
+    operator delete(p);
+}
+void* operator new[](const std::size_t size){
+    return operator new(size);
+}
+void operator delete[](void* p) noexcept {
+    operator delete(p);
+}
+void operator delete[](void* p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+namespace{
+    // Peak resident set size of the process in bytes.
+    std::size_t peakRss(){
+#if defined(__linux__)
+        // VmHWM, unlike ru_maxrss, is reset by resetPeakRss()
+        std::ifstream status("/proc/self/status");
+        for(std::string line; std::getline(status, line);){
+            if(line.compare(0, 6, "VmHWM:") == 0){
+                return std::stoul(line.substr(6)) * 1024;
+            }
+        }
+        return 0;
+#elif defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize : 0;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+    #if defined(__APPLE__)
+        return static_cast<std::size_t>(usage.ru_maxrss);
+    #else
+        return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+    #endif
+#endif
+    }
+    // Lets the next peakRss() report the peak of what follows, where the system supports it (Linux).
+    void resetPeakRss(){
+#if defined(__linux__)
+        std::ofstream("/proc/self/clear_refs") << "5";
+#endif
+    }
+
+    struct result{
+        std::string operation;
+        std::string shape;
+        std::string engine;
+        std::size_t bytes = 0;
+        double seconds = 0;
+        double operations = 0;// for lookups, the number of lookups, otherwise 0
+        std::size_t allocations = 0;
+        std::size_t allocated = 0;
+        std::size_t peak = 0;
+    };
+
+    struct options{
+        std::vector<std::size_t> sizes{1 << 20, 16 << 20};
+        std::vector<bench::corpus_shape> shapes{std::begin(bench::all_shapes), std::end(bench::all_shapes)};
+        std::vector<parse_engine> engines{parse_engine::tokens, parse_engine::direct, parse_engine::parallel, parse_engine::lazy};
+        std::size_t repeat = 3;
+        std::string out;
+    };
+
+    std::string_view engineName(const parse_engine e) noexcept {
+        switch (e){
+            case parse_engine::tokens:
+                return "tokens";
+            case parse_engine::direct:
+                return "direct";
+            case parse_engine::lazy:
+                return "lazy";
+            default:
+                return "parallel";
+        }
+    }
+
+    std::vector<std::string> split(const std::string& list){
+        std::vector<std::string> parts;
+        std::stringstream in(list);
+        for(std::string part; std::getline(in, part, ',');){
+            if(!part.empty()){
+                parts.push_back(part);
+            }
+        }
+        return parts;
+    }
+    // 512, 64K, 16M, 1G
+    std::size_t parseSize(const std::string& s){
+        std::size_t multiplier = 1;
+        switch (s.empty() ? '\0' : s.back()){
+            case 'K': case 'k':
+                multiplier = std::size_t(1) << 10;
+                break;
+            case 'M': case 'm':
+                multiplier = std::size_t(1) << 20;
+                break;
+            case 'G': case 'g':
+                multiplier = std::size_t(1) << 30;
+                break;
+            default:
+                break;
+        }
+        return static_cast<std::size_t>(std::stod(s)) * multiplier;
+    }
+
+    options parseOptions(const int argc, char** argv){
+        options o;
+        for(int i = 1; i < argc; ++i){
+            const std::string arg = argv[i];
+            const auto eq = arg.find('=');
+            const std::string key = arg.substr(0, eq), value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+            if(key == "--sizes"){
+                o.sizes.clear();
+                for(const auto& s : split(value)){
+                    o.sizes.push_back(parseSize(s));
+                }
+            }else if(key == "--shapes"){
+                o.shapes.clear();
+                for(const auto& s : split(value)){
+                    o.shapes.push_back(bench::shapeFromName(s));
+                }
+            }else if(key == "--engines"){
+                o.engines.clear();
+                for(const auto& e : split(value)){
+                    o.engines.push_back(e == "tokens" ? parse_engine::tokens : e == "direct" ? parse_engine::direct : e == "lazy" ? parse_engine::lazy : parse_engine::parallel);
+                }
+            }else if(key == "--repeat"){
+                o.repeat = std::max<std::size_t>(1, std::stoul(value));
+            }else if(key == "--out"){
+                o.out = value;
+            }else{
+                throw std::runtime_error("Unknown option " + arg);
+            }
+        }
+        return o;
+    }
+
+    // Runs setup() then body() repeat times and keeps the fastest run of body, with its allocations and peak RSS.
+    template<class Setup, class Body>
+    result measure(const std::size_t repeat, Setup&& setup, Body&& body){
+        result best;
+        best.seconds = -1;
+        for(std::size_t r = 0; r < repeat; ++r){
+            setup();
+            resetPeakRss();
+            const std::size_t count = allocationCount.load(), bytes = allocatedBytes.load();
+            const auto start = std::chrono::steady_clock::now();
+            body();
+            const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if(best.seconds < 0 || elapsed < best.seconds){
+                best.seconds = elapsed;
+                best.allocations = allocationCount.load() - count;
+                best.allocated = allocatedBytes.load() - bytes;
+                best.peak = peakRss();
+            }
+        }
+        return best;
+    }
+
+    // Number of elements in the tree below n, with the walk a full scan of the tree does.
+    std::size_t elementCount(const node& n){
+        std::size_t count = 0;
+        std::vector<const node*> pending{&n};
+        while(!pending.empty()){
+            const node* p = pending.back();
+            pending.pop_back();
+            count += p->getType() == node_type::ELEMENT_NODE;
+            for(const auto& c : p->getChildren()){
+                pending.push_back(c.get());
+            }
+        }
+        return count;
+    }
+
+    void writeJson(std::ostream& out, const std::vector<result>& results){
+        out << "{\n  \"library\": \"miniXML\",\n  \"threads\": " << thread_pool::shared().size() << ",\n  \"results\": [\n";
+        for(std::size_t i = 0; i < results.size(); ++i){
+            const result& r = results[i];
+            const double mbps = r.seconds > 0 ? static_cast<double>(r.bytes) / (1 << 20) / r.seconds : 0;
+            out << "    {\"operation\": \"" << r.operation << "\", \"shape\": \"" << r.shape << "\", \"engine\": \"" << r.engine
+                << "\", \"bytes\": " << r.bytes << ", \"seconds\": " << r.seconds << ", \"mb_per_second\": " << mbps;
+            if(r.operations > 0){
+                out << ", \"operations_per_second\": " << r.operations / r.seconds;
+            }
+            out << ", \"allocations\": " << r.allocations << ", \"allocated_bytes\": " << r.allocated << ", \"peak_rss_bytes\": " << r.peak << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    }
+}
+
+int main(int argc, char** argv){
+    try{
+        const options o = parseOptions(argc, argv);
+        const std::filesystem::path scratch = std::filesystem::temp_directory_path();
+        const std::string inputFile = (scratch / "miniXML_bench_input.xml").string();
+        const std::string outputFile = (scratch / "miniXML_bench_output.xml").string();
+        const std::string snapshotFile = (scratch / "miniXML_bench.snapshot").string();
+        std::vector<result> results;
+
+        for(const auto shape : o.shapes){
+            for(const auto size : o.sizes){
+                const std::string xml = bench::corpus_generator().generate(shape, size);
+                std::ofstream(inputFile, std::ios::binary).write(xml.data(), static_cast<std::streamsize>(xml.size()));
+                auto record = [&](result r, const std::string_view operation, const std::string& engine){
+                    r.operation = operation;
+                    r.shape = bench::shapeName(shape);
+                    r.engine = engine;
+                    r.bytes = xml.size();
+                    std::cerr << r.operation << " " << r.shape << " " << r.engine << " " << r.bytes << ": " << r.seconds << " s\n";
+                    results.push_back(std::move(r));
+                };
+
+                std::unique_ptr<document> d;
+                for(const auto engine : o.engines){
+                    record(measure(o.repeat, [&]{ d = std::make_unique<document>(); }, [&]{ d->parseFromString(xml, engine); }),
+                        "parseFromString", std::string(engineName(engine)));
+                    record(measure(o.repeat, [&]{ d.reset(); }, [&]{ d = std::make_unique<document>(inputFile, engine); }),
+                        "file_read", std::string(engineName(engine)));
+                    record(measure(o.repeat, [&]{ d.reset(); }, [&]{ d = std::make_unique<document>(inputFile, engine, load_mode::map); }),
+                        "file_map", std::string(engineName(engine)));
+                    record(measure(o.repeat, [&]{ d = std::make_unique<document>(inputFile, engine); }, [&]{ d.reset(); }),
+                        "teardown", std::string(engineName(engine)));
+                }
+                // scaling of the parallel engine with the number of threads
+                if(std::find(o.engines.begin(), o.engines.end(), parse_engine::parallel) != o.engines.end()){
+                    const std::size_t hardware = thread_pool::shared().size();
+                    for(std::size_t threads = 1; ; threads = std::min(threads * 2, hardware)){
+                        thread_pool pool(threads);
+                        record(measure(o.repeat, [&]{
+                            d = std::make_unique<document>();
+                            d->setThreadPool(&pool);
+                        }, [&]{ d->parseFromString(xml, parse_engine::parallel); }), "parseFromString", "parallel_x" + std::to_string(threads));
+                        if(threads == hardware){
+                            break;
+                        }
+                    }
+                }
+
+                d = std::make_unique<document>(inputFile, parse_engine::direct);
+                std::size_t written = 0;
+                record(measure(o.repeat, []{}, [&]{ written += d->rootNode().toString().size(); }), "toString", "direct");
+                record(measure(o.repeat, []{}, [&]{ d->writeToFile(outputFile); }), "writeToFile", "direct");// no pool, so serial
+                // scaling of the parallel writer, which is only used for documents of 128 KB or more
+                for(std::size_t threads = 1, hardware = thread_pool::shared().size(); ; threads = std::min(threads * 2, hardware)){
+                    thread_pool pool(threads);
+                    d->setThreadPool(&pool);
+                    record(measure(o.repeat, []{}, [&]{ written += d->toString().size(); }), "toString", "parallel_x" + std::to_string(threads));
+                    record(measure(o.repeat, []{}, [&]{ d->writeToFile(outputFile); }), "writeToFile", "parallel_x" + std::to_string(threads));
+                    if(threads == hardware){
+                        break;
+                    }
+                }
+                d->setThreadPool(nullptr);
+
+                // name lookups below the corpus element, which has the most children in every shape
+                const node* corpus = d->rootNode().findChild("corpus");
+                constexpr std::size_t lookups = 100000;
+                std::size_t found = 0;
+                result lookup = measure(o.repeat, []{}, [&]{
+                    for(std::size_t i = 0; i < lookups; ++i){
+                        found += corpus->findChild(bench::corpus_generator::elementName(i)) != nullptr;
+                    }
+                });
+                lookup.operations = lookups;
+                record(lookup, "findChild", "direct");
+
+                // every record of the corpus as a message of its own, parsed one document at a time and as batches
+                std::vector<std::string> messages;
+                for(const auto& c : corpus->getChildren()){
+                    if(c->getType() == node_type::ELEMENT_NODE){
+                        messages.push_back(c->toString(0, output_format::compact));
+                    }
+                }
+                const std::vector<std::string_view> inputs(messages.begin(), messages.end());
+                std::vector<std::unique_ptr<document>> parsed(inputs.size());
+                record(measure(o.repeat, [&]{ parsed.clear(); parsed.resize(inputs.size()); }, [&]{
+                    for(std::size_t i = 0; i < inputs.size(); ++i){
+                        parsed[i] = std::make_unique<document>();
+                        parsed[i]->parseFromString(inputs[i], parse_engine::direct);
+                    }
+                }), "parse_messages", "direct");
+                parsed.clear();
+                document reused;
+                reused.setReuseMemory(true);
+                record(measure(o.repeat, []{}, [&]{
+                    for(const auto message : inputs){
+                        reused.parseFromString(message, parse_engine::direct);
+                    }
+                }), "parse_messages", "direct_reuse");
+                for(std::size_t threads = 1, hardware = thread_pool::shared().size(); ; threads = std::min(threads * 2, hardware)){
+                    thread_pool pool(threads);
+                    batch_parser batch(parse_engine::direct, &pool);
+                    record(measure(o.repeat, []{}, [&]{ batch.parse(inputs); }), "parse_messages", "batch_x" + std::to_string(threads));
+                    if(threads == hardware){
+                        break;
+                    }
+                }
+
+                // full scans and a query over the tree and over the compact form
+                compact_document compact;
+                record(measure(o.repeat, []{}, [&]{ compact.parseFromString(xml); }), "parseFromString", "compact");
+                std::size_t scanned = 0;
+                record(measure(o.repeat, []{}, [&]{ scanned += elementCount(d->rootNode()); }), "scan", "direct");
+                record(measure(o.repeat, []{}, [&]{
+                    for(compact_document::index i = 0; i < compact.size(); ++i){
+                        scanned += compact.getType(i) == node_type::ELEMENT_NODE;
+                    }
+                }), "scan", "compact");
+                const query items("//item");
+                record(measure(o.repeat, []{}, [&]{ scanned += items.count(d->rootNode()); }), "query", "direct");
+                record(measure(o.repeat, []{}, [&]{ scanned += compact.select(items).size(); }), "query", "compact");
+                // reloading from a binary snapshot instead of parsing
+                compact.save(snapshotFile);
+                compact_document loaded;
+                record(measure(o.repeat, []{}, [&]{ loaded.load(snapshotFile); }), "snapshot_load", "compact");
+                record(measure(o.repeat, []{}, [&]{ scanned += loaded.select(items).size(); }), "query", "snapshot");
+                // subtree hashes of a freshly parsed tree, then finding one changed attribute against comparing serialized trees
+                std::unique_ptr<document> h;
+                std::uint64_t hashed = 0;
+                for(std::size_t threads = 1, hardware = thread_pool::shared().size(); ; threads = std::min(threads * 2, hardware)){
+                    thread_pool pool(threads);
+                    record(measure(o.repeat, [&]{
+                        h = std::make_unique<document>();
+                        h->setThreadPool(&pool);
+                        h->parseFromString(xml, parse_engine::direct);
+                    }, [&]{ hashed += h->computeHashes(); }), "computeHashes", "direct_x" + std::to_string(threads));
+                    if(threads == hardware){
+                        break;
+                    }
+                }
+                h.reset();
+                document changed;
+                changed.parseFromString(xml, parse_engine::direct);
+                node* target = changed.rootNode().findChild("corpus");
+                if(const auto records = target->findChildren(node_type::ELEMENT_NODE); !records.empty()){
+                    target = records.back();
+                }
+                target->appendAttribute("changed", "1");
+                hashed += d->computeHashes() + changed.computeHashes();
+                record(measure(o.repeat, []{}, [&]{ scanned += diff(d->rootNode(), changed.rootNode()).size(); }), "diff", "hashed");
+                record(measure(o.repeat, []{}, [&]{ scanned += d->rootNode().toString() == changed.rootNode().toString(); }), "diff", "toString");
+                volatile std::size_t sink = written + found + scanned + hashed;// keeps the measured loops from being optimized away
+                (void)sink;
+            }
+        }
+        std::filesystem::remove(inputFile);
+        std::filesystem::remove(outputFile);
+        std::filesystem::remove(snapshotFile);
+
+        if(o.out.empty()){
+            writeJson(std::cout, results);
+        }else{
+            std::ofstream out(o.out);
+            writeJson(out, results);
+        }
+    }catch(const std::exception& e){
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
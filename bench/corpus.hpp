@@ -0,0 +1,158 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Synthetic documents for the benchmarks. Every shape stresses one part of the parsers and is generated
+// deterministically from a seed, so the same arguments always give the same bytes.
+namespace miniXML::bench{
+    enum class corpus_shape{
+        deep,// chains of nested elements
+        wide,// one element with a very large number of small children
+        attributes,// elements with many attributes and little else
+        text,// long text runs with whitespace to collapse
+        markup// comments and processing instructions between small elements
+    };
+
+    inline constexpr corpus_shape all_shapes[] = {corpus_shape::deep, corpus_shape::wide, corpus_shape::attributes, corpus_shape::text, corpus_shape::markup};
+
+    [[nodiscard]] inline std::string_view shapeName(const corpus_shape s) noexcept {
+        switch (s){
+            case corpus_shape::deep:
+                return "deep";
+            case corpus_shape::wide:
+                return "wide";
+            case corpus_shape::attributes:
+                return "attributes";
+            case corpus_shape::text:
+                return "text";
+            default:
+                return "markup";
+        }
+    }
+    [[nodiscard]] inline corpus_shape shapeFromName(const std::string_view name){
+        for(const auto s : all_shapes){
+            if(shapeName(s) == name){
+                return s;
+            }
+        }
+        throw std::runtime_error("Unknown corpus shape " + std::string(name));
+    }
+
+    class corpus_generator{
+        public:
+            static constexpr std::size_t chainDepth = 200;
+
+            explicit corpus_generator(const std::uint64_t seed = 1) noexcept : state(seed ? seed : 1){}
+
+            // A document of roughly bytes bytes, it stops after the first record that reaches the size.
+            [[nodiscard]] std::string generate(const corpus_shape shape, const std::size_t bytes){
+                std::string xml;
+                xml.reserve(bytes + 4096);
+                xml += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<corpus>\n";
+                while(xml.size() < bytes){
+                    switch (shape){
+                        case corpus_shape::deep:
+                            deep(xml);
+                            break;
+                        case corpus_shape::wide:
+                            wide(xml);
+                            break;
+                        case corpus_shape::attributes:
+                            attributes(xml);
+                            break;
+                        case corpus_shape::text:
+                            text(xml);
+                            break;
+                        default:
+                            markup(xml);
+                            break;
+                    }
+                }
+                xml += "</corpus>\n";
+                return xml;
+            }
+            // The names elements are drawn from, e.g. for lookups.
+            [[nodiscard]] static std::string_view elementName(const std::size_t i) noexcept {
+                constexpr std::string_view names[] = {"item", "entry", "record", "node", "value", "section", "field", "data"};
+                return names[i % 8];
+            }
+        private:
+            std::uint64_t state;
+
+            [[nodiscard]] std::uint64_t next() noexcept {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                return state;
+            }
+            [[nodiscard]] std::string_view word() noexcept {
+                constexpr std::string_view words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit",
+                    "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore", "et"};
+                return words[next() % 16];
+            }
+
+            void deep(std::string& xml){
+                const std::size_t depth = 1 + next() % chainDepth;
+                for(std::size_t d = 0; d < depth; ++d){
+                    xml += '<';
+                    xml += elementName(d);
+                    xml += " level=\"" + std::to_string(d) + "\">";
+                }
+                xml += word();
+                for(std::size_t d = depth; d-- > 0;){
+                    xml += "</";
+                    xml += elementName(d);
+                    xml += '>';
+                }
+                xml += '\n';
+            }
+            void wide(std::string& xml){
+                const std::string_view name = elementName(next());
+                xml += "  <";
+                xml += name;
+                xml += " id=\"" + std::to_string(next() % 1000000) + "\">";
+                xml += word();
+                xml += "</";
+                xml += name;
+                xml += ">\n";
+            }
+            void attributes(std::string& xml){
+                xml += "  <";
+                xml += elementName(next());
+                const std::size_t count = 4 + next() % 9;
+                for(std::size_t a = 0; a < count; ++a){
+                    xml += " a" + std::to_string(a) + (a % 2 ? "='" : "=\"");
+                    xml += word();
+                    xml += std::to_string(next() % 1000);
+                    xml += a % 2 ? "'" : "\"";
+                }
+                xml += "/>\n";
+            }
+            void text(std::string& xml){
+                xml += "  <p>";
+                const std::size_t words = 20 + next() % 200;
+                for(std::size_t w = 0; w < words; ++w){
+                    xml += word();
+                    xml += next() % 7 == 0 ? "\n      " : (next() % 5 == 0 ? "   " : " ");
+                }
+                xml += "</p>\n";
+            }
+            void markup(std::string& xml){
+                xml += "  <!-- ";
+                xml += word();
+                xml += ' ';
+                xml += word();
+                xml += " -->\n  <?process target=\"";
+                xml += word();
+                xml += "\" mode='fast'?>\n  <";
+                const std::string_view name = elementName(next());
+                xml += name;
+                xml += "><!-- inner --></";
+                xml += name;
+                xml += ">\n";
+            }
+    };
+};
\ No newline at end of file
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <vector>
+#include "stats.hpp"
+
+// Bump allocator owned by a document.
+// Nodes, their child lists and attribute maps are carved out of a few large blocks,
+// nothing is freed individually and all blocks are released together with the arena.
+namespace miniXML::details{
+    class arena{
+        public:
+            arena() = default;
+            arena(const arena&) = delete;
+            arena& operator=(const arena&) = delete;
+
+            [[nodiscard]] void* allocate(const std::size_t size, const std::size_t alignment = alignof(std::max_align_t)){
+                std::size_t offset = align(used, alignment);
+                if(offset + size > capacity){
+                    grow(size + alignment);
+                    offset = align(used, alignment);
+                }
+                used = offset + size;
+                return current + offset;
+            }
+            // Copies s into the arena, the returned view lives as long as the arena.
+            [[nodiscard]] std::string_view copy(const std::string_view s){
+                if(s.empty()){
+                    return {};
+                }
+                char* p = static_cast<char*>(allocate(s.size(), 1));
+                std::memcpy(p, s.data(), s.size());
+                return {p, s.size()};
+            }
+            // Frees every block at once, everything allocated from the arena becomes invalid.
+            void release() noexcept {
+                blocks.clear();
+                current = nullptr;
+                used = capacity = 0;
+                nextBlock = firstBlock;
+                reused = 0;
+            }
+            // Like release(), but keeps the blocks and hands them out again before reserving new ones,
+            // so refilling the arena with about as much as before doesn't touch the heap.
+            void rewind() noexcept {
+                current = nullptr;
+                used = capacity = 0;
+                reused = 0;
+            }
+            [[nodiscard]] std::size_t blockCount() const noexcept {
+                return blocks.size();
+            }
+            [[nodiscard]] std::size_t bytesReserved() const noexcept {
+                std::size_t total = 0;
+                for(const auto& b : blocks){
+                    total += b.size;
+                }
+                return total;
+            }
+            // Blocks taken from the heap since the arena was created, blocks handed out again after rewind() don't count.
+            [[nodiscard]] allocation_count heapAllocations() const noexcept {
+                return allocated;
+            }
+        private:
+            struct block{
+                std::unique_ptr<std::byte[]> data;
+                std::size_t size;
+            };
+            static constexpr std::size_t firstBlock = 4096;
+            static constexpr std::size_t maxBlock = std::size_t(1) << 20;
+
+            std::vector<block> blocks;
+            std::byte* current = nullptr;
+            std::size_t used = 0;
+            std::size_t capacity = 0;
+            std::size_t nextBlock = firstBlock;
+            std::size_t reused = 0;// blocks before this one are in use since the last rewind()
+            allocation_count allocated;
+
+            [[nodiscard]] std::size_t align(const std::size_t offset, const std::size_t alignment) const noexcept {
+                const auto address = reinterpret_cast<std::uintptr_t>(current) + offset;
+                return offset + ((alignment - address % alignment) % alignment);
+            }
+            void grow(const std::size_t minimum){
+                while(reused < blocks.size()){
+                    const block& b = blocks[reused++];
+                    if(b.size >= minimum){
+                        current = b.data.get();
+                        used = 0;
+                        capacity = b.size;
+                        return;
+                    }
+                }
+                const std::size_t size = minimum > nextBlock ? minimum : nextBlock;
+                blocks.push_back({std::make_unique<std::byte[]>(size), size});
+                ++allocated.allocations;
+                allocated.bytes += size;
+                reused = blocks.size();
+                current = blocks.back().data.get();
+                used = 0;
+                capacity = size;
+                if(nextBlock < maxBlock){
+                    nextBlock *= 2;
+                }
+            }
+    };
+
+    // Standard allocator interface over an arena, used by the containers of arena owned nodes.
+    // Without an arena it falls back to the global heap, which is what nodes created by users get.
+    template<class T>
+    class arena_allocator{
+        public:
+            using value_type = T;
+
+            arena_allocator() noexcept = default;
+            explicit arena_allocator(arena* a) noexcept : source(a){}
+            template<class U>
+            arena_allocator(const arena_allocator<U>& other) noexcept : source(other.source){}
+
+            [[nodiscard]] T* allocate(const std::size_t n){
+                if(source){
+                    return static_cast<T*>(source->allocate(n * sizeof(T), alignof(T)));
+                }
+                countAllocation(n * sizeof(T));
+                return std::allocator<T>().allocate(n);
+            }
+            void deallocate(T* p, const std::size_t n) noexcept {
+                if(!source){
+                    std::allocator<T>().deallocate(p, n);
+                }
+            }
+            friend bool operator==(const arena_allocator& a, const arena_allocator& b) noexcept {
+                return a.source == b.source;
+            }
+            friend bool operator!=(const arena_allocator& a, const arena_allocator& b) noexcept {
+                return a.source != b.source;
+            }
+        private:
+            arena* source = nullptr;
+
+            template<class U>
+            friend class arena_allocator;
+    };
+};
\ No newline at end of file
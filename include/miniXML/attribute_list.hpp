@@ -0,0 +1,112 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <utility>
+#include "arena.hpp"
+#include "xml_string.hpp"
+
+// Attribute storage of a node.
+// Attributes stay in source order, so documents are written back the way they were read.
+namespace miniXML::details{
+    using attribute = std::pair<xml_string, xml_string>;
+
+    // Flat list of name/value pairs. The first attribute is stored in the list itself, more go to the allocator,
+    // which is the document arena for parsed nodes. Elements have a handful of attributes, so lookups scan the list,
+    // which is faster than hashing the key at these sizes.
+    class attribute_list{
+        public:
+            using allocator_type = arena_allocator<attribute>;
+            using iterator = attribute*;
+            using const_iterator = const attribute*;
+            static constexpr std::uint32_t inlineCapacity = 1;
+
+            explicit attribute_list(const allocator_type& a = allocator_type()) noexcept : alloc(a), items(local()){}
+            attribute_list(const attribute_list&) = delete;
+            attribute_list& operator=(const attribute_list&) = delete;
+            ~attribute_list(){
+                clear();
+                release();
+            }
+
+            [[nodiscard]] iterator begin() noexcept {
+                return items;
+            }
+            [[nodiscard]] iterator end() noexcept {
+                return items + count;
+            }
+            [[nodiscard]] const_iterator begin() const noexcept {
+                return items;
+            }
+            [[nodiscard]] const_iterator end() const noexcept {
+                return items + count;
+            }
+            [[nodiscard]] std::size_t size() const noexcept {
+                return count;
+            }
+            [[nodiscard]] bool empty() const noexcept {
+                return count == 0;
+            }
+
+            [[nodiscard]] iterator find(const std::string_view name) noexcept {
+                return std::find_if(begin(), end(), [name](const attribute& a){
+                    return a.first == name;
+                });
+            }
+            [[nodiscard]] const_iterator find(const std::string_view name) const noexcept {
+                return const_cast<attribute_list*>(this)->find(name);
+            }
+            // Replaces the value if the name is already present, otherwise appends the pair.
+            void insert_or_assign(xml_string name, xml_string value){
+                if(const auto it = find(name.view()); it != end()){
+                    it->second = std::move(value);
+                    return;
+                }
+                if(count == capacity){
+                    grow();
+                }
+                new (items + count) attribute(std::move(name), std::move(value));
+                ++count;
+            }
+            iterator erase(const_iterator pos) noexcept {
+                const auto at = const_cast<iterator>(pos);
+                std::move(at + 1, end(), at);
+                items[--count].~attribute();
+                return at;
+            }
+            void clear() noexcept {
+                for(auto& a : *this){
+                    a.~attribute();
+                }
+                count = 0;
+            }
+        private:
+            allocator_type alloc;
+            attribute* items;
+            std::uint32_t count = 0;
+            std::uint32_t capacity = inlineCapacity;
+            alignas(attribute) unsigned char storage[sizeof(attribute) * inlineCapacity];
+
+            [[nodiscard]] attribute* local() noexcept {
+                return reinterpret_cast<attribute*>(storage);
+            }
+            void grow(){
+                const std::uint32_t larger = std::max<std::uint32_t>(4, capacity * 2);
+                attribute* moved = alloc.allocate(larger);
+                for(std::uint32_t i = 0; i < count; ++i){
+                    new (moved + i) attribute(std::move(items[i]));
+                    items[i].~attribute();
+                }
+                release();
+                items = moved;
+                capacity = larger;
+            }
+            void release() noexcept {
+                if(items != local()){
+                    alloc.deallocate(items, capacity);
+                }
+            }
+    };
+};
\ No newline at end of file
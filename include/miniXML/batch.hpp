@@ -0,0 +1,77 @@
+#pragma once
+#include <exception>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "document.hpp"
+
+// Parses many small documents at once, spread over a thread pool.
+namespace miniXML{
+    class batch_parser{
+        public:
+            // parse_engine::parallel parses every input with the direct engine, the batch itself is already spread over the pool.
+            explicit batch_parser(const details::parse_engine e = details::parse_engine::direct, details::thread_pool* p = nullptr) noexcept
+                : engine(e == details::parse_engine::parallel ? details::parse_engine::direct : e), pool(p){}
+            batch_parser(const batch_parser&) = delete;
+            batch_parser& operator=(const batch_parser&) = delete;
+
+            // Parses every input into its own document, results are in the order of the inputs.
+            // An input that fails doesn't stop the others, its error is kept and rethrown by getDocument().
+            // The documents of the previous batch are reused with document::setReuseMemory(), so their trees become invalid.
+            // Every result stays valid until the next batch, so memory is kept per input slot rather than per thread: slot i
+            // holds the arena blocks input i of earlier batches needed and at most document::maxReusedSymbols names.
+            void parse(const std::vector<std::string_view>& inputs){
+                details::thread_pool& workers = pool ? *pool : details::thread_pool::shared();
+                documents.resize(inputs.size());
+                errors.assign(inputs.size(), nullptr);
+                scratch.resize(workers.size());
+                workers.parallelFor(inputs.size(), [&](const std::size_t i, const std::size_t worker){
+                    if(!documents[i]){
+                        documents[i] = std::make_unique<document>();
+                        documents[i]->setReuseMemory(true);
+                    }
+                    document& d = *documents[i];
+                    d.setMaxDepth(maxDepth);
+                    // the token vector of the thread, so its capacity carries over from one input to the next
+                    d.tokens.swap(scratch[worker]);
+                    try{
+                        d.parseFromString(inputs[i], engine);
+                    }catch(...){
+                        errors[i] = std::current_exception();
+                        d.reset();
+                    }
+                    d.tokens.swap(scratch[worker]);
+                    scratch[worker].clear();
+                });
+            }
+            // Number of inputs of the last batch.
+            [[nodiscard]] std::size_t size() const noexcept {
+                return documents.size();
+            }
+            // The document parsed from input i, rethrows the error of that input if it failed.
+            [[nodiscard]] document& getDocument(const std::size_t i){
+                if(errors.at(i)){
+                    std::rethrow_exception(errors[i]);
+                }
+                return *documents[i];
+            }
+            // The error of input i, null if it was parsed.
+            [[nodiscard]] std::exception_ptr getError(const std::size_t i) const {
+                return errors.at(i);
+            }
+            // Applies to every document of the following batches, see document::setMaxDepth().
+            void setMaxDepth(const std::size_t depth) noexcept {
+                maxDepth = depth;
+            }
+            [[nodiscard]] std::size_t getMaxDepth() const noexcept {
+                return maxDepth;
+            }
+        private:
+            details::parse_engine engine;
+            details::thread_pool* pool;
+            std::size_t maxDepth = document::defaultMaxDepth;
+            std::vector<std::unique_ptr<document>> documents;
+            std::vector<std::exception_ptr> errors;
+            std::vector<std::vector<details::token>> scratch;// per worker of the pool
+    };
+};
\ No newline at end of file
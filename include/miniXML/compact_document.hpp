@@ -0,0 +1,662 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document.hpp"
+#include "query.hpp"
+
+// Read optimized form of a document: the nodes are stored in document order as parallel arrays, linked by indices.
+// A full scan is a loop over the arrays, and every subtree is one contiguous run of indices.
+namespace miniXML{
+    class compact_document{
+        public:
+            using index = std::uint32_t;
+            // No node, e.g. the parent of the document node or the next sibling of a last child.
+            static constexpr index npos = std::numeric_limits<index>::max();
+
+            // Holds only the document node, at index 0.
+            compact_document(){
+                clear();
+            }
+            // The nodes of n and its subtree, below a document node unless n is one.
+            explicit compact_document(const node& n){
+                assign(n);
+            }
+            compact_document(const compact_document&) = delete;
+            compact_document& operator=(const compact_document&) = delete;
+
+            // Parses xml straight into the arrays, with the rules of the direct engine, so the nodes are those its tree holds.
+            void parseFromString(const std::string_view xml){
+                clear();
+                try{
+                    build(xml);
+                }catch(...){
+                    clear();// the arrays may have moved while they were filled
+                    throw;
+                }
+                publish();
+            }
+            // Replaces the nodes with those of n and its subtree, see the constructor.
+            void assign(const node& n){
+                clear();
+                try{
+                    build(n);
+                }catch(...){
+                    clear();
+                    throw;
+                }
+                publish();
+            }
+            // Replaces the tree of d with nodes built from the arrays. Names are interned in d and strings copied into its arena.
+            void toDocument(document& d) const {
+                d.reset();
+                details::symbol_cache symbols(d.names);
+                std::vector<node*> built(size(), nullptr);
+                built[0] = &d.root;
+                for(index i = 1; i < size(); ++i){
+                    const auto t = getType(i);
+                    node_ptr n = t == details::node_type::ELEMENT_NODE
+                        ? document::makeElement(d.memory, symbols.intern(getValue(i)))
+                        : document::makeNode(d.memory, t, d.memory.copy(getValue(i)));
+                    for(index a = at.attributeStarts[i]; a < at.attributeStarts[i + 1]; ++a){
+                        n->attributes.insert_or_assign(details::xml_string::borrow(symbols.intern(symbolNames[at.attributeNames[a]]).name),
+                            details::xml_string::borrow(d.memory.copy(textAt(at.attributeOffsets[a], at.attributeLengths[a]))));
+                    }
+                    built[i] = built[at.parents[i]]->appendChild(std::move(n));
+                }
+            }
+
+            // Writes the arrays, the names and the text to a binary snapshot that load() maps back in place.
+            // The snapshot uses the byte order of the machine that writes it.
+            void save(const std::string& filepath) const {
+                std::ofstream out(filepath, std::ios::binary);
+                if(!out){
+                    throw std::runtime_error("Failed to open file");
+                }
+                std::vector<std::uint32_t> nameOffsets{0};
+                std::string nameBytes;
+                for(std::size_t id = 1; id < symbolNames.size(); ++id){
+                    nameBytes.append(symbolNames[id]);
+                    nameOffsets.push_back(static_cast<std::uint32_t>(nameBytes.size()));
+                }
+                const std::size_t attributes = at.attributeStarts[at.count];
+                snapshot_header header{};
+                std::memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+                header.version = snapshotVersion;
+                header.byteOrder = snapshotByteOrder;
+                header.nodes = at.count;
+                header.attributes = attributes;
+                header.symbols = symbolNames.size() - 1;
+                header.nameBytes = nameBytes.size();
+                header.textBytes = at.textBytes;
+                std::size_t written = 0;
+                auto put = [&](const void* p, const std::size_t bytes){
+                    static constexpr char padding[snapshotAlignment] = {};
+                    out.write(static_cast<const char*>(p), static_cast<std::streamsize>(bytes));
+                    written += bytes;
+                    const std::size_t pad = (snapshotAlignment - written % snapshotAlignment) % snapshotAlignment;
+                    out.write(padding, static_cast<std::streamsize>(pad));
+                    written += pad;
+                };
+                put(&header, sizeof(header));
+                put(at.types, at.count);
+                for(const auto* a : {at.nameIds, at.valueOffsets, at.valueLengths, at.firstChildren, at.nextSiblings, at.parents}){
+                    put(a, at.count * sizeof(std::uint32_t));
+                }
+                put(at.attributeStarts, (at.count + 1) * sizeof(std::uint32_t));
+                for(const auto* a : {at.attributeNames, at.attributeOffsets, at.attributeLengths}){
+                    put(a, attributes * sizeof(std::uint32_t));
+                }
+                put(nameOffsets.data(), nameOffsets.size() * sizeof(std::uint32_t));
+                put(nameBytes.data(), nameBytes.size());
+                put(at.text, at.textBytes);
+                if(!out.flush()){
+                    throw std::runtime_error("Failed to write file");
+                }
+            }
+            // Loads a snapshot written by save(). With load_mode::map the arrays are used in place in the mapping,
+            // so loading costs one pass that checks their indices and text ranges, plus interning the distinct names.
+            void load(const std::string& filepath, const details::load_mode mode = details::load_mode::map){
+                clear();
+                std::string_view bytes;
+                if(mode == details::load_mode::read){
+                    std::ifstream f(filepath, std::ios::binary | std::ios::ate);
+                    if(!f){
+                        throw std::runtime_error("Failed to open file");
+                    }
+                    stored.resize(static_cast<std::size_t>(f.tellg()));
+                    f.seekg(0);
+                    f.read(stored.data(), static_cast<std::streamsize>(stored.size()));
+                    bytes = stored;
+                }else{
+                    mapping = details::mapped_file(filepath, mode == details::load_mode::map_populate);
+                    bytes = mapping.view();
+                }
+                try{
+                    attach(bytes);
+                }catch(...){
+                    clear();
+                    throw;
+                }
+            }
+
+            // Number of nodes, including the document node at 0.
+            [[nodiscard]] index size() const noexcept {
+                return static_cast<index>(at.count);
+            }
+            [[nodiscard]] details::node_type getType(const index i) const noexcept {
+                return static_cast<details::node_type>(at.types[i]);
+            }
+            // The name of an element, the content of other nodes, like node::getValue().
+            [[nodiscard]] std::string_view getValue(const index i) const noexcept {
+                return at.nameIds[i] != details::no_symbol ? symbolNames[at.nameIds[i]] : textAt(at.valueOffsets[i], at.valueLengths[i]);
+            }
+            // Id of the element name in symbols(), no_symbol for other nodes.
+            [[nodiscard]] details::symbol_id getSymbol(const index i) const noexcept {
+                return at.nameIds[i];
+            }
+            [[nodiscard]] index getParent(const index i) const noexcept {
+                return at.parents[i];
+            }
+            [[nodiscard]] index getFirstChild(const index i) const noexcept {
+                return at.firstChildren[i];
+            }
+            [[nodiscard]] index getNextSibling(const index i) const noexcept {
+                return at.nextSiblings[i];
+            }
+            // One past the last node of the subtree of i, the subtree is [i, getSubtreeEnd(i)).
+            [[nodiscard]] index getSubtreeEnd(index i) const noexcept {
+                while(i != npos && at.nextSiblings[i] == npos){
+                    i = at.parents[i];
+                }
+                return i == npos ? size() : at.nextSiblings[i];
+            }
+            [[nodiscard]] std::size_t getAttributeCount(const index i) const noexcept {
+                return at.attributeStarts[i + 1] - at.attributeStarts[i];
+            }
+            // The k-th attribute of i as name and value, in source order.
+            [[nodiscard]] std::pair<std::string_view, std::string_view> getAttribute(const index i, const std::size_t k) const {
+                const std::size_t a = at.attributeStarts[i] + k;
+                return {symbolNames[at.attributeNames[a]], textAt(at.attributeOffsets[a], at.attributeLengths[a])};
+            }
+            [[nodiscard]] std::optional<std::string_view> getAttribute(const index i, const std::string_view key) const {
+                const details::symbol_id id = names.find(key).id;
+                for(index a = at.attributeStarts[i]; id != details::no_symbol && a < at.attributeStarts[i + 1]; ++a){
+                    if(at.attributeNames[a] == id){
+                        return textAt(at.attributeOffsets[a], at.attributeLengths[a]);
+                    }
+                }
+                return std::nullopt;
+            }
+            [[nodiscard]] details::symbol findSymbol(const std::string_view name) const {
+                return names.find(name);
+            }
+            [[nodiscard]] const details::symbol_table& symbols() const noexcept {
+                return names;
+            }
+            // Deepest nesting of elements parseFromString() accepts, see document::setMaxDepth().
+            void setMaxDepth(const std::size_t depth) noexcept {
+                maxDepth = depth;
+            }
+
+            // The nodes q selects from context, in document order, like query::select() on the tree.
+            // Names are compared by symbol id and only subtrees some step can continue in are visited.
+            [[nodiscard]] std::vector<index> select(const query& q, index context = 0) const {
+                std::vector<compiled_step> steps;
+                bool counting = false;
+                for(const auto& s : q.plan()){
+                    steps.push_back({&s, names.find(s.name).id, resolve(s.before), resolve(s.after)});
+                    counting = counting || s.position != 0;
+                }
+                if(q.isAbsolute()){
+                    context = 0;
+                }
+                const std::size_t count = steps.size();
+                const std::uint64_t done = std::uint64_t(1) << count;
+                std::vector<index> results;
+                std::vector<search_frame> stack{{at.firstChildren[context], 1}};
+                std::vector<std::uint32_t> counters(counting ? count : 0, 0);// per frame and step, the children counted for [n]
+                while(!stack.empty()){
+                    search_frame& f = stack.back();
+                    if(f.child == npos){
+                        stack.pop_back();
+                        counters.resize(counting ? stack.size() * count : 0);
+                        continue;
+                    }
+                    const index c = f.child;
+                    f.child = at.nextSiblings[c];
+                    std::uint32_t* counted = counting ? counters.data() + (stack.size() - 1) * count : nullptr;
+                    std::uint64_t next = 0;
+                    for(std::size_t k = 0; k < count; ++k){
+                        if(!(f.states & (std::uint64_t(1) << k))){
+                            continue;
+                        }
+                        const compiled_step& s = steps[k];
+                        if(s.step->descendant){
+                            next |= std::uint64_t(1) << k;// the context of // stays open below
+                        }
+                        if(!matches(s, c) || !passes(s.before, c)){
+                            continue;
+                        }
+                        if(s.step->position && ++counted[k] != s.step->position){
+                            continue;
+                        }
+                        if(passes(s.after, c)){
+                            next |= std::uint64_t(1) << (k + 1);
+                        }
+                    }
+                    if(next & done){
+                        results.push_back(c);
+                    }
+                    if((next & ~done) && at.firstChildren[c] != npos){
+                        stack.push_back({at.firstChildren[c], next & ~done});
+                        if(counting){
+                            counters.resize(stack.size() * count, 0);
+                        }
+                    }
+                }
+                return results;
+            }
+        private:
+            void build(const std::string_view xml){
+                text.reserve(xml.size() / 2);
+                details::lexer lex(xml);
+                details::symbol_cache symbols(names);
+                details::markup m;
+                std::vector<frame> open{{0, npos}};
+                while(lex.next(m)){
+                    switch (m.type){
+                        case details::markup_type::start_tag:
+                        case details::markup_type::empty_tag:{
+                            if(open.size() > maxDepth){
+                                throw std::runtime_error("Elements are nested deeper than " + std::to_string(maxDepth) + " levels");
+                            }
+                            const index element = append(details::node_type::ELEMENT_NODE, open.back());
+                            nameIds.back() = known(symbols.intern(m.name));
+                            std::string_view name, value;
+                            const bool references = details::hasReferences(m.body);
+                            while(details::nextAttribute(m.body, name, value)){
+                                appendAttribute(known(symbols.intern(name)), value, references);
+                            }
+                            if(m.type == details::markup_type::start_tag){
+                                open.push_back({element, npos});
+                            }
+                            break;
+                        }
+                        case details::markup_type::end_tag:{
+                            if(open.size() == 1){
+                                break;// a stray closing tag, the tree engines skip those as well
+                            }
+                            const std::string_view name = symbolNames[nameIds[open.back().n]];
+                            if(m.name != name){
+                                throw std::runtime_error("Closing tag of " + std::string(name) + " doesn't match!");
+                            }
+                            open.pop_back();
+                            break;
+                        }
+                        case details::markup_type::text:{
+                            if(open.size() > 1){// text outside of the root element isn't kept
+                                const std::string_view trimmed = details::trimSpace(m.body);
+                                if(!trimmed.empty()){
+                                    append(details::node_type::TEXT_NODE, open.back());
+                                    appendCollapsed(trimmed);
+                                    decodeLast();
+                                }
+                            }
+                            break;
+                        }
+                        case details::markup_type::cdata:{
+                            if(open.size() > 1){
+                                append(details::node_type::TEXT_NODE, open.back());
+                                appendText(m.body);
+                            }
+                            break;
+                        }
+                        case details::markup_type::comment:{
+                            append(details::node_type::COMMENT_NODE, open.back());
+                            appendCollapsed(details::trimSpace(m.body));
+                            break;
+                        }
+                        case details::markup_type::processing_instruction:{
+                            append(details::node_type::PROCESSING_INSTRUCTION_NODE, open.back());
+                            appendText(details::normalizeInstruction(m.body));
+                            break;
+                        }
+                        default:
+                            break;// declarations such as <!DOCTYPE> aren't kept
+                    }
+                }
+            }
+            void build(const node& n){
+                struct source{
+                    const node* n;
+                    frame added;
+                    std::size_t next;// the child added next
+                };
+                std::vector<source> pending;// nodes whose children are being added, innermost last
+                auto add = [&](const node& c, frame& parent){
+                    const index i = append(c.getType(), parent);
+                    if(c.getType() == details::node_type::ELEMENT_NODE){
+                        nameIds.back() = known(names.intern(c.getValue()));
+                        for(const auto& a : c.getAttributes()){
+                            appendAttribute(known(names.intern(a.first.view())), a.second.view());
+                        }
+                    }else{
+                        appendText(c.getValue());
+                    }
+                    if(!c.getChildren().empty()){
+                        pending.push_back({&c, {i, npos}, 0});
+                    }
+                };
+                if(n.getType() == details::node_type::DOCUMENT_NODE){
+                    pending.push_back({&n, {0, npos}, 0});
+                }else{
+                    frame top{0, npos};
+                    add(n, top);
+                }
+                while(!pending.empty()){
+                    source& p = pending.back();
+                    if(p.next == p.n->getChildren().size()){
+                        pending.pop_back();
+                        continue;
+                    }
+                    add(*p.n->getChildren()[p.next++], p.added);// add() uses p before it can move
+                }
+            }
+            struct frame{
+                index n;
+                index last;// the last child added to n so far
+            };
+            struct search_frame{
+                index child;// the child visited next
+                std::uint64_t states;// bit k: the parent of child is a context of step k
+            };
+            struct compiled_predicate{
+                details::symbol_id attribute;
+                const details::query_step::predicate* source;
+            };
+            struct compiled_step{
+                const details::query_step* step;
+                details::symbol_id name;
+                std::vector<compiled_predicate> before;
+                std::vector<compiled_predicate> after;
+            };
+
+            std::vector<std::uint8_t> types;// node_type
+            std::vector<details::symbol_id> nameIds;
+            std::vector<std::uint32_t> valueOffsets;// into text
+            std::vector<std::uint32_t> valueLengths;
+            std::vector<index> firstChildren;
+            std::vector<index> nextSiblings;
+            std::vector<index> parents;
+            std::vector<index> attributeStarts;// the attributes of i are [attributeStarts[i], attributeStarts[i + 1])
+            std::vector<details::symbol_id> attributeNames;
+            std::vector<std::uint32_t> attributeOffsets;
+            std::vector<std::uint32_t> attributeLengths;
+            details::symbol_table names;
+            std::vector<std::string_view> symbolNames;// by id, so reading a name doesn't lock the table
+            std::string text;// every value and attribute value, back to back in document order
+            std::size_t maxDepth = document::defaultMaxDepth;
+
+            // The arrays the accessors read: the vectors above, or the sections of a loaded snapshot.
+            struct arrays{
+                std::size_t count = 0;
+                const std::uint8_t* types = nullptr;
+                const details::symbol_id* nameIds = nullptr;
+                const std::uint32_t* valueOffsets = nullptr;
+                const std::uint32_t* valueLengths = nullptr;
+                const index* firstChildren = nullptr;
+                const index* nextSiblings = nullptr;
+                const index* parents = nullptr;
+                const index* attributeStarts = nullptr;
+                const details::symbol_id* attributeNames = nullptr;
+                const std::uint32_t* attributeOffsets = nullptr;
+                const std::uint32_t* attributeLengths = nullptr;
+                const char* text = nullptr;
+                std::size_t textBytes = 0;
+            };
+            arrays at;
+            details::mapped_file mapping;// a snapshot loaded with load_mode::map
+            std::string stored;// a snapshot loaded with load_mode::read
+
+            // A snapshot is this header followed by the arrays, the name table and the text, each padded to snapshotAlignment.
+            struct snapshot_header{
+                char magic[8];
+                std::uint32_t version;
+                std::uint32_t byteOrder;
+                std::uint64_t nodes;
+                std::uint64_t attributes;
+                std::uint64_t symbols;// names, without the empty one of id 0
+                std::uint64_t nameBytes;
+                std::uint64_t textBytes;
+            };
+            static constexpr char snapshotMagic[8] = {'m', 'i', 'n', 'i', 'X', 'M', 'L', 's'};
+            static constexpr std::uint32_t snapshotVersion = 1;
+            static constexpr std::uint32_t snapshotByteOrder = 0x01020304;
+            static constexpr std::size_t snapshotAlignment = 8;
+
+            // Points the accessors at the vectors.
+            void publish() noexcept {
+                at = {types.size(), types.data(), nameIds.data(), valueOffsets.data(), valueLengths.data(), firstChildren.data(),
+                    nextSiblings.data(), parents.data(), attributeStarts.data(), attributeNames.data(), attributeOffsets.data(),
+                    attributeLengths.data(), text.data(), text.size()};
+            }
+            // Points the accessors at the sections of the snapshot in bytes, only the names are copied out.
+            void attach(const std::string_view bytes){
+                std::size_t used = 0;
+                auto section = [&](const std::size_t size){
+                    if(bytes.size() - used < size){
+                        throw std::runtime_error("Invalid snapshot: the file is truncated");
+                    }
+                    const char* p = bytes.data() + used;
+                    used += size + (snapshotAlignment - size % snapshotAlignment) % snapshotAlignment;
+                    used = std::min(used, bytes.size());
+                    return p;
+                };
+                snapshot_header header;
+                std::memcpy(&header, section(sizeof(header)), sizeof(header));
+                if(std::memcmp(header.magic, snapshotMagic, sizeof(header.magic)) != 0 || header.version != snapshotVersion){
+                    throw std::runtime_error("Invalid snapshot: not a miniXML snapshot of this version");
+                }
+                if(header.byteOrder != snapshotByteOrder){
+                    throw std::runtime_error("Invalid snapshot: written with another byte order");
+                }
+                if(header.nodes == 0 || header.nodes >= npos || header.attributes >= npos || header.symbols >= npos){
+                    throw std::runtime_error("Invalid snapshot: bad counts");
+                }
+                const auto n = static_cast<std::size_t>(header.nodes), a = static_cast<std::size_t>(header.attributes);
+                auto words = [&](const std::size_t count){
+                    return reinterpret_cast<const std::uint32_t*>(section(count * sizeof(std::uint32_t)));
+                };
+                arrays loaded;
+                loaded.count = n;
+                loaded.types = reinterpret_cast<const std::uint8_t*>(section(n));
+                loaded.nameIds = words(n);
+                loaded.valueOffsets = words(n);
+                loaded.valueLengths = words(n);
+                loaded.firstChildren = words(n);
+                loaded.nextSiblings = words(n);
+                loaded.parents = words(n);
+                loaded.attributeStarts = words(n + 1);
+                loaded.attributeNames = words(a);
+                loaded.attributeOffsets = words(a);
+                loaded.attributeLengths = words(a);
+                const std::uint32_t* nameOffsets = words(static_cast<std::size_t>(header.symbols) + 1);
+                const char* nameBytes = section(static_cast<std::size_t>(header.nameBytes));
+                loaded.text = section(static_cast<std::size_t>(header.textBytes));
+                loaded.textBytes = static_cast<std::size_t>(header.textBytes);
+                for(std::size_t id = 1; id <= header.symbols; ++id){
+                    if(nameOffsets[id - 1] > nameOffsets[id] || nameOffsets[id] > header.nameBytes){
+                        throw std::runtime_error("Invalid snapshot: bad name table");
+                    }
+                    if(known(names.intern(std::string_view(nameBytes + nameOffsets[id - 1], nameOffsets[id] - nameOffsets[id - 1]))) != id){
+                        throw std::runtime_error("Invalid snapshot: bad name table");
+                    }
+                }
+                check(loaded, a);
+                at = loaded;
+            }
+            // Checks every index and text range of loaded once, so the accessors and the walks over the links can trust them.
+            // Children and siblings come after a node and parents before it, as in document order, so no walk can loop.
+            void check(const arrays& loaded, const std::size_t a) const {
+                const std::size_t n = loaded.count;
+                auto inText = [&loaded](const std::uint32_t offset, const std::uint32_t length){
+                    return std::uint64_t(offset) + length <= loaded.textBytes;
+                };
+                auto after = [n](const index link, const std::size_t i){
+                    return link == npos || (link > i && link < n);
+                };
+                if(loaded.types[0] != static_cast<std::uint8_t>(details::node_type::DOCUMENT_NODE) || loaded.parents[0] != npos
+                    || loaded.nextSiblings[0] != npos || loaded.attributeStarts[0] != 0){
+                    throw std::runtime_error("Invalid snapshot: bad document node");
+                }
+                for(std::size_t i = 0; i < n; ++i){
+                    const auto type = loaded.types[i];
+                    if(type < static_cast<std::uint8_t>(details::node_type::ELEMENT_NODE) || type > static_cast<std::uint8_t>(details::node_type::PROCESSING_INSTRUCTION_NODE)
+                        || loaded.nameIds[i] >= symbolNames.size() || !inText(loaded.valueOffsets[i], loaded.valueLengths[i])){
+                        throw std::runtime_error("Invalid snapshot: bad node " + std::to_string(i));
+                    }
+                    if(!after(loaded.firstChildren[i], i) || !after(loaded.nextSiblings[i], i) || (i != 0 && loaded.parents[i] >= i)){
+                        throw std::runtime_error("Invalid snapshot: bad links of node " + std::to_string(i));
+                    }
+                    if(loaded.attributeStarts[i] > loaded.attributeStarts[i + 1]){
+                        throw std::runtime_error("Invalid snapshot: bad attributes of node " + std::to_string(i));
+                    }
+                }
+                if(loaded.attributeStarts[n] != a){
+                    throw std::runtime_error("Invalid snapshot: bad attribute count");
+                }
+                for(std::size_t k = 0; k < a; ++k){
+                    if(loaded.attributeNames[k] == details::no_symbol || loaded.attributeNames[k] >= symbolNames.size()
+                        || !inText(loaded.attributeOffsets[k], loaded.attributeLengths[k])){
+                        throw std::runtime_error("Invalid snapshot: bad attribute " + std::to_string(k));
+                    }
+                }
+            }
+
+            void clear(){
+                mapping.close();
+                stored.clear();
+                types.clear();
+                for(auto* v : {&nameIds, &valueOffsets, &valueLengths, &firstChildren, &nextSiblings, &parents, &attributeStarts,
+                    &attributeNames, &attributeOffsets, &attributeLengths}){
+                    v->clear();
+                }
+                names.clear();
+                symbolNames.assign(1, std::string_view());
+                text.clear();
+                attributeStarts.push_back(0);
+                frame none{npos, npos};
+                append(details::node_type::DOCUMENT_NODE, none);
+                publish();
+            }
+            // Keeps a lock free copy of the name of s and returns its id.
+            details::symbol_id known(const details::symbol& s){
+                if(s.id >= symbolNames.size()){
+                    symbolNames.resize(s.id + 1);
+                    symbolNames[s.id] = s.name;
+                }
+                return s.id;
+            }
+            // Adds a node without value or attributes as the last child of parent.
+            index append(const details::node_type t, frame& parent){
+                if(types.size() == npos){
+                    throw std::runtime_error("Too many nodes for a compact_document");
+                }
+                const auto i = static_cast<index>(types.size());
+                types.push_back(static_cast<std::uint8_t>(t));
+                nameIds.push_back(details::no_symbol);
+                valueOffsets.push_back(static_cast<std::uint32_t>(text.size()));
+                valueLengths.push_back(0);
+                firstChildren.push_back(npos);
+                nextSiblings.push_back(npos);
+                parents.push_back(parent.n);
+                attributeStarts.push_back(attributeStarts.back());
+                if(parent.n != npos){
+                    (parent.last == npos ? firstChildren[parent.n] : nextSiblings[parent.last]) = i;
+                    parent.last = i;
+                }
+                return i;
+            }
+            // Sets the value of the last node.
+            void appendText(const std::string_view s){
+                reserveText(s.size());
+                text.append(s);
+                valueLengths.back() = static_cast<std::uint32_t>(s.size());
+            }
+            void appendCollapsed(const std::string_view trimmed){
+                reserveText(trimmed.size());
+                const std::size_t from = text.size();
+                text.resize(from + trimmed.size());
+                const std::size_t n = details::collapseWhitespace(trimmed, text.data() + from);
+                text.resize(from + n);
+                valueLengths.back() = static_cast<std::uint32_t>(n);
+            }
+            // Decodes the entities in the value of the last node, in place.
+            void decodeLast(){
+                std::uint32_t& length = valueLengths.back();
+                char* value = text.data() + valueOffsets.back();
+                if(details::hasReferences({value, length})){
+                    length = static_cast<std::uint32_t>(details::decodeEntities({value, length}, value));
+                    text.resize(valueOffsets.back() + length);
+                }
+            }
+            // Adds an attribute to the last node, decoding the entities of value when decode is set.
+            void appendAttribute(const details::symbol_id name, const std::string_view value, const bool decode = false){
+                reserveText(value.size());
+                attributeNames.push_back(name);
+                attributeOffsets.push_back(static_cast<std::uint32_t>(text.size()));
+                const std::size_t from = text.size();
+                text.append(value);
+                if(decode && details::hasReferences(value)){
+                    text.resize(from + details::decodeEntities({text.data() + from, value.size()}, text.data() + from));
+                }
+                attributeLengths.push_back(static_cast<std::uint32_t>(text.size() - from));
+                ++attributeStarts.back();
+            }
+            void reserveText(const std::size_t n) const {
+                if(text.size() + n > std::numeric_limits<std::uint32_t>::max()){
+                    throw std::runtime_error("Too much text for a compact_document");
+                }
+            }
+            [[nodiscard]] std::string_view textAt(const std::uint32_t offset, const std::uint32_t length) const noexcept {
+                return std::string_view(at.text + offset, length);
+            }
+
+            [[nodiscard]] std::vector<compiled_predicate> resolve(const std::vector<details::query_step::predicate>& predicates) const {
+                std::vector<compiled_predicate> compiled;
+                for(const auto& p : predicates){
+                    compiled.push_back({names.find(p.attribute).id, &p});
+                }
+                return compiled;
+            }
+            [[nodiscard]] bool passes(const std::vector<compiled_predicate>& predicates, const index i) const noexcept {
+                for(const auto& p : predicates){
+                    index a = at.attributeStarts[i];
+                    while(a < at.attributeStarts[i + 1] && (p.attribute == details::no_symbol || at.attributeNames[a] != p.attribute)){
+                        ++a;
+                    }
+                    if(a == at.attributeStarts[i + 1] || (p.source->hasValue && textAt(at.attributeOffsets[a], at.attributeLengths[a]) != p.source->value)){
+                        return false;
+                    }
+                }
+                return true;
+            }
+            [[nodiscard]] bool matches(const compiled_step& s, const index i) const noexcept {
+                switch (s.step->test){
+                    case details::query_step::test_type::text:
+                        return getType(i) == details::node_type::TEXT_NODE;
+                    case details::query_step::test_type::any:
+                        return getType(i) == details::node_type::ELEMENT_NODE;
+                    default:
+                        return s.name != details::no_symbol && at.nameIds[i] == s.name;
+                }
+            }
+    };
+};
\ No newline at end of file
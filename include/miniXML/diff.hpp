@@ -0,0 +1,164 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "node.hpp"
+
+// Structural diff of two trees, built on node::getHash().
+namespace miniXML{
+    namespace details{
+        // added: after is a new subtree and before is null. removed: before is gone and after is null.
+        // modified: before and after are the same kind of node at the same place, but their value or attributes differ.
+        // An element whose changes are all further down isn't listed itself, only the changes below it are.
+        enum class change_type{
+            added,
+            removed,
+            modified
+        };
+        struct node_change{
+            change_type type;
+            const node* before;
+            const node* after;
+        };
+
+        // Nodes of the same type, and elements with the same name, are compared. Others replace each other.
+        [[nodiscard]] inline bool sameKind(const node& a, const node& b) noexcept {
+            return a.getType() == b.getType() && (a.getType() != node_type::ELEMENT_NODE || a.getValue() == b.getValue());
+        }
+        [[nodiscard]] inline bool sameContent(const node& a, const node& b){
+            if(a.getValue() != b.getValue()){
+                return false;
+            }
+            const auto& x = a.getAttributes();
+            const auto& y = b.getAttributes();
+            if(x.size() != y.size()){
+                return false;
+            }
+            for(auto i = x.begin(), j = y.begin(); i != x.end(); ++i, ++j){
+                if(i->first != j->first.view() || i->second != j->second.view()){
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        class differ{
+            public:
+                [[nodiscard]] std::vector<node_change> run(const node& before, const node& after){
+                    if(before.getHash() == after.getHash()){
+                        return {};
+                    }
+                    if(!sameKind(before, after)){
+                        return {{change_type::removed, &before, nullptr}, {change_type::added, nullptr, &after}};
+                    }
+                    compare(before, after);
+                    // one frame of pending steps per pair of nodes being compared, so deep trees don't recurse
+                    while(!frames.empty()){
+                        auto& f = frames.back();
+                        if(f.next == f.steps.size()){
+                            frames.pop_back();
+                            continue;
+                        }
+                        const step s = f.steps[f.next++];
+                        if(s.before && s.after){
+                            compare(*s.before, *s.after);
+                        }else{
+                            changes.push_back({s.before ? change_type::removed : change_type::added, s.before, s.after});
+                        }
+                    }
+                    return std::move(changes);
+                }
+            private:
+                struct step{
+                    const node* before;
+                    const node* after;
+                };
+                struct frame{
+                    std::vector<step> steps;
+                    std::size_t next = 0;
+                };
+                std::vector<node_change> changes;
+                std::vector<frame> frames;
+
+                // Two nodes of the same kind whose hashes differ.
+                void compare(const node& a, const node& b){
+                    if(!sameContent(a, b)){
+                        changes.push_back({change_type::modified, &a, &b});
+                    }
+                    const auto& x = a.getChildren();
+                    const auto& y = b.getChildren();
+                    // the children that hash equal at both ends are skipped, what's between is matched up
+                    std::size_t first = 0;
+                    while(first < x.size() && first < y.size() && x[first]->getHash() == y[first]->getHash()){
+                        ++first;
+                    }
+                    std::size_t endX = x.size();
+                    std::size_t endY = y.size();
+                    while(endX > first && endY > first && x[endX - 1]->getHash() == y[endY - 1]->getHash()){
+                        --endX;
+                        --endY;
+                    }
+                    if(first == endX && first == endY){
+                        return;// only the node itself changed
+                    }
+                    frame f;
+                    // how often each hash is still ahead on either side, a child that is ahead on the other side stays and
+                    // what is in front of it was added or removed
+                    std::unordered_map<std::uint64_t, std::size_t> aheadX;
+                    std::unordered_map<std::uint64_t, std::size_t> aheadY;
+                    for(std::size_t i = first; i < endX; ++i){
+                        ++aheadX[x[i]->getHash()];
+                    }
+                    for(std::size_t j = first; j < endY; ++j){
+                        ++aheadY[y[j]->getHash()];
+                    }
+                    std::size_t i = first;
+                    std::size_t j = first;
+                    while(i < endX && j < endY){
+                        const node& c = *x[i];
+                        const node& d = *y[j];
+                        if(c.getHash() == d.getHash()){
+                            --aheadX[c.getHash()];
+                            --aheadY[d.getHash()];
+                            ++i;
+                            ++j;
+                        }else if(aheadY[c.getHash()]){
+                            f.steps.push_back({nullptr, &d});
+                            --aheadY[d.getHash()];
+                            ++j;
+                        }else if(aheadX[d.getHash()]){
+                            f.steps.push_back({&c, nullptr});
+                            --aheadX[c.getHash()];
+                            ++i;
+                        }else{
+                            if(sameKind(c, d)){
+                                f.steps.push_back({&c, &d});
+                            }else{
+                                f.steps.push_back({&c, nullptr});
+                                f.steps.push_back({nullptr, &d});
+                            }
+                            --aheadX[c.getHash()];
+                            --aheadY[d.getHash()];
+                            ++i;
+                            ++j;
+                        }
+                    }
+                    for(; i < endX; ++i){
+                        f.steps.push_back({x[i].get(), nullptr});
+                    }
+                    for(; j < endY; ++j){
+                        f.steps.push_back({nullptr, y[j].get()});
+                    }
+                    frames.push_back(std::move(f));
+                }
+        };
+    }
+
+    // The changes that turn the subtree before into the subtree after, in document order.
+    // Subtrees that hash equal are skipped without walking them, so after the hashes are computed (document::computeHashes()
+    // does it in parallel) the diff only walks the paths down to the changes. A child that moved shows up as removed and added.
+    [[nodiscard]] inline std::vector<details::node_change> diff(const node& before, const node& after){
+        return details::differ().run(before, after);
+    }
+};
\ No newline at end of file
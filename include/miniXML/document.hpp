@@ -1,28 +1,61 @@
 #pragma once
 #include "node.hpp"
+#include "lexer.hpp"
+#include "mapped_file.hpp"
+#include "thread_pool.hpp"
+#include "stats.hpp"
+#include <atomic>
 #include <fstream>
-#include <sstream>
+#include <iterator>
 
 // The implementation of the document class as a top level controller of the tree.
 namespace miniXML{
+    class incremental_parser;
+    class path_filter;
+    class compact_document;
+    class batch_parser;
+
     class document{
         public:
+            static constexpr std::size_t defaultMaxDepth = 10000;
+            // A symbol table kept by setReuseMemory() that holds more names than this is started over on the next parse.
+            static constexpr std::size_t maxReusedSymbols = 4096;
+
             //constructor used for reading from a file
-            document(const std::string& filepath) : root(details::node_type::DOCUMENT_NODE, "") {
-                std::ifstream f(filepath);
-                if(!f){
-                    throw std::runtime_error("Failed to open file");
+            document(const std::string& filepath, details::parse_engine engine = details::parse_engine::tokens, details::load_mode mode = details::load_mode::read,
+                std::size_t depthLimit = defaultMaxDepth)
+                : root(details::node_type::DOCUMENT_NODE, ""), maxDepth(depthLimit) {
+                if(mode == details::load_mode::read){
+                    std::ifstream f(filepath, std::ios::binary);
+                    if(!f){
+                        throw std::runtime_error("Failed to open file");
+                    }
+                    // read straight into content, there is no intermediate stream buffer to copy out of;
+                    // pipes and other files that can't seek have no size, so they are read as they come
+                    const std::streamoff size = f.seekg(0, std::ios::end) ? static_cast<std::streamoff>(f.tellg()) : -1;
+                    if(size < 0){
+                        f.clear();
+                        content.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+                    }else{
+                        content.resize(static_cast<std::size_t>(size));
+                        f.seekg(0);
+                        f.read(content.data(), static_cast<std::streamsize>(size));
+                        if(f.gcount() != size){
+                            throw std::runtime_error("Failed to read file");// it got shorter while being read
+                        }
+                    }
+                    input = content;
+                }else{
+                    mapping = details::mapped_file(filepath, mode == details::load_mode::map_populate);
+                    input = mapping.view();
                 }
-                std::stringstream buffer;
-                
-                buffer << f.rdbuf();
-
-                content = buffer.str();
-                tokenize();
-                buildTree();
+                parse(engine);
             }
             //constructor used for generating a document
             document() : root(details::node_type::DOCUMENT_NODE, ""){}
+            // Parsed nodes point into content and the arena, so a document stays where it was created.
+            document(const document&) = delete;
+            document& operator=(const document&) = delete;
 
             [[nodiscard]] node& rootNode() noexcept {
                 return root;
@@ -30,29 +63,330 @@ namespace miniXML{
             [[nodiscard]] const node& rootNode() const noexcept {
                 return root;
             }
-            void writeToFile(const std::string& filepath, int depth = 0) const {
-                std::ofstream file(filepath);
-                for(const auto& c : root.getChildren()){
-                    writeNode(*c, file, depth);    
+            // Trees with at least two chunks of output are written on the pool set with setThreadPool(), if any,
+            // see details::parallel_writer. The output is the same as that of the serial writer.
+            void writeToFile(const std::string& filepath, int depth = 0, details::output_format format = details::output_format::indented) const {
+                std::ofstream file(filepath, std::ios::binary);
+                if(!file){
+                    throw std::runtime_error("Failed to open file");
+                }
+                std::size_t written = 0;
+                double seconds = 0;
+                {
+                    details::phase_timer timer(seconds);
+                    if(details::thread_pool* workers = treePool()){
+                        written = details::parallel_writer(*workers, format).write(root, static_cast<std::size_t>(depth), file);
+                    }else{
+                        details::output_buffer out(file);
+                        details::serializer(out, format).write(root, static_cast<std::size_t>(depth));
+                        out.flush();
+                        written = out.written();
+                    }
+                }
+                countWrite(written, seconds);
+            }
+            // rootNode().toString(), written on the pool like writeToFile() for large trees.
+            [[nodiscard]] std::string toString(int depth = 0, details::output_format format = details::output_format::indented) const {
+                std::string s;
+                double seconds = 0;
+                {
+                    details::phase_timer timer(seconds);
+                    if(details::thread_pool* workers = treePool()){
+                        s = details::parallel_writer(*workers, format).str(root, static_cast<std::size_t>(depth));
+                    }else{
+                        s = root.toString(depth, format);
+                    }
                 }
+                countWrite(s.size(), seconds);
+                return s;
+            }
+            // Counters of the last parse and of the writes since, all zero unless MINIXML_STATS is enabled, see stats.hpp.
+            // Writes can run on several threads at once, so their counters are kept apart and copied in here.
+            [[nodiscard]] details::document_stats stats() const noexcept {
+                details::document_stats s = statistics;
+                s.writeSeconds = static_cast<double>(writeNanoseconds.load(std::memory_order_relaxed)) / 1e9;
+                s.bytesWritten = bytesWritten.load(std::memory_order_relaxed);
+                return s;
+            }
+            // The symbol of an element or attribute name, to look up children by id with node::findChild().
+            // Its id is no_symbol if no parsed element has that name. It is valid until the document is parsed again.
+            [[nodiscard]] details::symbol findSymbol(const std::string_view name) const {
+                return names.find(name);
+            }
+            [[nodiscard]] const details::symbol_table& symbols() const noexcept {
+                return names;
+            }
+            // Deepest nesting of elements the parsers accept, the root element is at 1. Deeper input fails with a runtime_error.
+            // Parsing, serialization and destruction don't recurse, so the limit only guards against hostile input.
+            void setMaxDepth(const std::size_t depth) noexcept {
+                maxDepth = depth;
+            }
+            [[nodiscard]] std::size_t getMaxDepth() const noexcept {
+                return maxDepth;
+            }
+            // Pool used by parse_engine::parallel, the process wide one when none is set. The pool has to outlive the parsing.
+            // Writing and hashing large trees only use a pool set here, without one they stay on the calling thread.
+            void setThreadPool(details::thread_pool* p) noexcept {
+                pool = p;
             }
-            void parseFromString(std::string_view xmlContent){
+            // When set, parsing again keeps the memory of the previous tree for the new one: arena blocks, the names in the
+            // symbol table and the buffers of the parsers. With the direct engine, parsing messages of about the same shape
+            // then doesn't allocate at all. The symbol table only grows, up to maxReusedSymbols names, after which it is
+            // cleared and refilled, so this suits documents with a stable set of names.
+            void setReuseMemory(const bool reuse) noexcept {
+                reuseMemory = reuse;
+            }
+            [[nodiscard]] bool getReuseMemory() const noexcept {
+                return reuseMemory;
+            }
+            // node::getHash() of the whole tree. Trees with at least two chunks of output are split into subtrees that
+            // are hashed on the pool set with setThreadPool(), if any, then the top is hashed on this thread.
+            std::uint64_t computeHashes() const {
+                details::thread_pool* workers = root.hash ? nullptr : treePool();
+                if(workers){
+                    const auto subtrees = splitForHashing(workers->size() * subtreesPerThread);
+                    if(subtrees.size() > 1){
+                        workers->parallelFor(subtrees.size(), [&subtrees](const std::size_t i){
+                            (void)subtrees[i]->getHash();
+                        });
+                    }
+                }
+                return root.getHash();
+            }
+            void parseFromString(std::string_view xmlContent, details::parse_engine engine = details::parse_engine::tokens){
+                reset();
                 content.assign(xmlContent);
-                tokens.clear();
-                root.clearChildren();
-                tokenize();
-                buildTree();
+                input = content;
+                parse(engine);
             }
         private:
-            node root;
+            // declared before root, so the tree is destroyed before the storage it points into
+            details::arena memory;
+            std::vector<std::unique_ptr<details::arena>> workerMemory;// arenas the parallel engine filled on other threads
+            details::symbol_table names;// element and attribute names, parsed nodes point into it
             std::string content;
+            details::mapped_file mapping;
+            std::string_view input;// the bytes being parsed, either content or the mapping
+            node root;
             std::vector<details::token> tokens;
+            details::thread_pool* pool = nullptr;
+            std::size_t maxDepth = defaultMaxDepth;
+            bool reuseMemory = false;
+            details::document_stats statistics;// of the last parse, written by the non const parse paths only
+            details::allocation_count allocationsBefore;// allocationsSoFar() when the parse started
+            // the writes since, from const writes that may run on several threads
+            mutable std::atomic<std::uint64_t> writeNanoseconds{0};
+            mutable std::atomic<std::size_t> bytesWritten{0};
+            // Where the content of each element starts and ends in the input, in document order, kept by parse_engine::lazy.
+            struct element_span{
+                std::size_t start;
+                std::size_t end;
+            };
+            std::vector<element_span> spans;
+
+            // Inputs shorter than two of these are parsed serially by parse_engine::parallel.
+            static constexpr std::size_t minChunkSize = 64 * 1024;
+            // computeHashes() splits the tree into this many subtrees per thread, so uneven subtrees still balance out.
+            static constexpr std::size_t subtreesPerThread = 8;
+
+            // The pool to spread work on the whole tree over, null when none was set, the tree is small, there is only one
+            // thread or this thread already runs a task of the pool, e.g. when documents are written from its parallelFor().
+            // The size is the one of the tree, which may have been built or grown after parsing, not of the input.
+            // A lazily parsed tree is never spread, its first accesses parse and can't run on several threads at once.
+            [[nodiscard]] details::thread_pool* treePool() const {
+                if(!pool || pool->size() == 1 || pool->runningHere() || !spans.empty() || !details::outputReaches(root, 2 * minChunkSize)){
+                    return nullptr;
+                }
+                return pool;
+            }
+            // The subtrees without a hash a level at a time from the root, until there are at least count of them.
+            [[nodiscard]] std::vector<const node*> splitForHashing(const std::size_t count) const {
+                std::vector<const node*> subtrees{&root};
+                std::vector<const node*> below;
+                // a chain of single children doesn't split, so only the top levels are tried
+                for(int level = 0; level < 16 && subtrees.size() < count; ++level){
+                    below.clear();
+                    bool split = false;
+                    for(const node* n : subtrees){
+                        if(n->children.empty()){
+                            below.push_back(n);
+                            continue;
+                        }
+                        split = true;
+                        for(const auto& c : n->children){
+                            if(!c->hash){
+                                below.push_back(c.get());
+                            }
+                        }
+                    }
+                    if(!split){
+                        break;
+                    }
+                    subtrees.swap(below);
+                }
+                return subtrees;
+            }
+
+            // Top level result of parsing a range of the input: nodes, and closing tags of elements opened before the range, in order.
+            struct fragment{
+                struct item{
+                    node_ptr n;// null for a closing tag
+                    std::string_view closing;
+                    std::size_t levels = 0;// deepest nesting of elements in the subtree of n, n itself is at 1
+                };
+                std::vector<item> items;
+                std::vector<node*> open;// elements still open at the end of the range, outermost first
+                std::size_t end = 0;// one past the last markup of the range
+                std::size_t markups = 0;// only counted with stats enabled
+                std::exception_ptr error;
+            };
+            fragment scratch;// of parseDirect(), kept for its capacity
+
+
+            // Drops the tree and everything it pointed into.
+            void reset(){
+                tokens.clear();
+                spans.clear();
+                scratch.items.clear();// left over when the last parse failed
+                root.clearChildren();
+                if(reuseMemory){
+                    memory.rewind();
+                    for(auto& a : workerMemory){
+                        a->rewind();
+                    }
+                    if(names.size() > maxReusedSymbols){
+                        names.clear();
+                    }
+                }else{
+                    memory.release();
+                    workerMemory.clear();
+                    names.clear();
+                }
+                mapping.close();
+                content.clear();
+                input = {};
+            }
+            void parse(details::parse_engine engine){
+                if constexpr (details::stats_enabled){
+                    startStats();
+                    statistics.bytesScanned = input.size();
+                }
+                if(engine == details::parse_engine::direct){
+                    details::phase_timer timer(statistics.buildSeconds);
+                    parseDirect();
+                }else if(engine == details::parse_engine::parallel){
+                    details::phase_timer timer(statistics.buildSeconds);
+                    parseParallel();
+                }else if(engine == details::parse_engine::lazy){
+                    details::phase_timer timer(statistics.buildSeconds);
+                    parseLazy();
+                }else{
+                    {
+                        details::phase_timer timer(statistics.tokenizeSeconds);
+                        tokenize();
+                    }
+                    details::phase_timer timer(statistics.buildSeconds);
+                    buildTree();
+                }
+                if constexpr (details::stats_enabled){
+                    if(engine == details::parse_engine::tokens){
+                        statistics.tokens = tokens.size();
+                    }
+                    collectStats();
+                }
+            }
+            void countWrite(const std::size_t bytes, const double seconds) const noexcept {
+                if constexpr (details::stats_enabled){
+                    writeNanoseconds.fetch_add(static_cast<std::uint64_t>(seconds * 1e9), std::memory_order_relaxed);
+                    bytesWritten.fetch_add(bytes, std::memory_order_relaxed);
+                }
+            }
+            // Clears the counters before a parse.
+            void startStats(){
+                statistics = {};
+                writeNanoseconds = 0;
+                bytesWritten = 0;
+                allocationsBefore = allocationsSoFar();
+            }
+            // Blocks of the arenas and the allocations counted on this thread, the difference over a parse is what it allocated.
+            [[nodiscard]] details::allocation_count allocationsSoFar() const {
+                details::allocation_count total = details::heapAllocations;
+                const auto add = [&total](const details::allocation_count c){
+                    total.allocations += c.allocations;
+                    total.bytes += c.bytes;
+                };
+                add(memory.heapAllocations());
+                add(names.heapAllocations());
+                for(const auto& a : workerMemory){
+                    add(a->heapAllocations());
+                }
+                return total;
+            }
+            // Fills in the counters that can be read off the finished tree and the arenas.
+            void collectStats(){
+                statistics.nodes = {};
+                statistics.attributes = statistics.maxDepth = statistics.heapNodes = 0;
+                std::vector<std::pair<const node*, std::size_t>> pending{{&root, 0}};
+                while(!pending.empty()){
+                    const auto [n, depth] = pending.back();
+                    pending.pop_back();
+                    ++statistics.nodes[static_cast<std::size_t>(n->type)];
+                    statistics.attributes += n->attributes.size();
+                    statistics.maxDepth = std::max(statistics.maxDepth, depth);
+                    statistics.heapNodes += n != &root && !n->inArena;
+                    for(const auto& c : n->children){
+                        pending.push_back({c.get(), depth + 1});
+                    }
+                }
+                statistics.arenaBlocks = memory.blockCount() + names.blockCount();
+                statistics.arenaBytes = memory.bytesReserved() + names.bytesReserved();
+                for(const auto& a : workerMemory){
+                    statistics.arenaBlocks += a->blockCount();
+                    statistics.arenaBytes += a->bytesReserved();
+                }
+                const details::allocation_count now = allocationsSoFar();
+                statistics.allocations = now.allocations - allocationsBefore.allocations;
+                statistics.bytesAllocated = now.bytes - allocationsBefore.bytes;
+            }
+
+            [[noreturn]] void tooDeep() const {
+                throw std::runtime_error("Elements are nested deeper than " + std::to_string(maxDepth) + " levels");
+            }
+
+            [[nodiscard]] static node_ptr makeNode(details::arena& a, details::node_type t, std::string_view v){
+                void* place = a.allocate(sizeof(node), alignof(node));
+                return node_ptr(new (place) node(t, details::xml_string::borrow(v), a));
+            }
+            [[nodiscard]] static node_ptr makeElement(details::arena& a, const details::symbol& s){
+                auto element = makeNode(a, details::node_type::ELEMENT_NODE, s.name);
+                element->symbolId = s.id;
+                return element;
+            }
+            // Returns raw with whitespace collapsed, as a slice of raw when it already is, otherwise as a copy in the arena.
+            [[nodiscard]] static std::string_view collapse(details::arena& a, std::string_view raw);
+            // Returns raw with its entities decoded, as raw itself when it has none, otherwise as a copy in the arena.
+            [[nodiscard]] static std::string_view decode(details::arena& a, std::string_view raw);
 
             //defined in parser.hpp
+            node* appendEvent(node* current, const details::event& e);
+            void parseRange(fragment& f, details::arena& a, std::size_t from, std::size_t until);
+            node* stitch(node* current, std::size_t& depth, fragment& f);
+            void parseDirect();
+            void parseParallel();
+            void parseLazy();
+            void expand(node& n, std::size_t from, std::size_t until);
+            [[nodiscard]] details::lazy_content& lazyPart(node& n);
             void tokenize();
             void buildTree();
-            std::unique_ptr<node> parseElement(int& i);
-            void writeNode(const node& n, std::ostream& file, int depth = 0) const;
+            std::unique_ptr<node> parseStartTag(std::size_t& i, bool& empty);
+            std::unique_ptr<node> parseComment(std::size_t& i);
+            std::unique_ptr<node> parseInstruction(std::size_t& i);
+
+            friend class node;
+            friend class incremental_parser;
+            friend class path_filter;
+            friend class compact_document;
+            friend class batch_parser;
    };
 }
 
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Hashing behind node::getHash(). The functions are fixed, so hashes don't change between runs of a program.
+// They detect changes, they don't protect against inputs made to collide.
+namespace miniXML::details{
+    // Mixes v into h, the result depends on the order the values are mixed in.
+    [[nodiscard]] constexpr std::uint64_t mixHash(std::uint64_t h, const std::uint64_t v) noexcept {
+        h ^= v;
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9u;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebu;
+        h ^= h >> 31;
+        return h;
+    }
+    // Eight bytes at a time, the length goes in last so "a" and "a\0" differ.
+    [[nodiscard]] inline std::uint64_t hashBytes(const std::string_view s, std::uint64_t h) noexcept {
+        std::size_t i = 0;
+        for(; i + 8 <= s.size(); i += 8){
+            std::uint64_t word;
+            std::memcpy(&word, s.data() + i, 8);
+            h = mixHash(h, word);
+        }
+        if(i < s.size()){
+            std::uint64_t word = 0;
+            std::memcpy(&word, s.data() + i, s.size() - i);
+            h = mixHash(h, word);
+        }
+        return mixHash(h, s.size());
+    }
+};
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+#include "document.hpp"
+#include "reader.hpp"
+
+// Resumable parsing of a document that arrives in pieces, e.g. from a socket or a pipe.
+namespace miniXML{
+    class incremental_parser{
+        public:
+            // Starts a new parse into d, whatever d held before is dropped.
+            explicit incremental_parser(document& d) : target(d), current(&d.root){
+                target.reset();
+                if constexpr (details::stats_enabled){
+                    target.startStats();
+                }
+            }
+
+            // Appends the chunk to the input and adds every markup it completes to the tree.
+            // Chunks can end anywhere, the unfinished tail is kept until the next feed().
+            void feed(const std::string_view chunk){
+                if(finished){
+                    throw std::runtime_error("Input was already finished");
+                }
+                if constexpr (details::stats_enabled){
+                    target.statistics.bytesScanned += chunk.size();
+                }
+                input.feed(chunk);
+                drain();
+            }
+            // Processes what is left, which has to be complete markup or trailing text.
+            void finish(){
+                if(!finished){
+                    finished = true;
+                    input.finish();
+                    drain();
+                    if constexpr (details::stats_enabled){
+                        target.collectStats();
+                    }
+                }
+            }
+            // Number of elements that are open at the current position of the input.
+            [[nodiscard]] std::size_t depth() const noexcept {
+                return input.depth();
+            }
+        private:
+            document& target;
+            reader input;
+            node* current;
+            bool finished = false;
+
+            void drain(){
+                details::event e;
+                while(input.next(e)){
+                    current = target.appendEvent(current, e);
+                }
+            }
+    };
+};
\ No newline at end of file
@@ -0,0 +1,434 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <utility>
+#include "types.hpp"
+#include "scanner.hpp"
+
+// Single pass lexer used by the direct parse engine.
+// It never copies the input, every markup it returns is a view into the scanned buffer.
+namespace miniXML::details{
+    enum class markup_type{
+        start_tag,
+        empty_tag,
+        end_tag,
+        text,
+        cdata,
+        comment,
+        processing_instruction,
+        declaration
+    };
+
+    struct markup{
+        markup_type type;
+        std::string_view name;// tag name or PI target
+        std::string_view body;// attributes of a tag, text, comment or PI content
+    };
+
+    [[nodiscard]] inline bool isSpace(const char c) noexcept {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // Returns the position one past the markup starting at pos, or npos if the input ends inside it.
+    // Text runs end at the next '<', so a text run reaching the end of the input is reported as incomplete.
+    [[nodiscard]] inline std::size_t markupEnd(const std::string_view in, std::size_t pos) noexcept {
+        if(in[pos] != '<'){
+            return in.find('<', pos);
+        }
+        const std::string_view rest = in.substr(pos);
+        if(rest.size() < 2){
+            return std::string_view::npos;
+        }
+        if(rest[1] == '!'){
+            if(rest.size() < 4 && std::string_view("<!--").substr(0, rest.size()) == rest){
+                return std::string_view::npos;
+            }
+            if(rest.compare(0, 4, "<!--") == 0){
+                const auto end = in.find("-->", pos + 4);
+                return end == std::string_view::npos ? end : end + 3;
+            }
+            if(rest.size() < 9 && std::string_view("<![CDATA[").substr(0, rest.size()) == rest){
+                return std::string_view::npos;
+            }
+            if(rest.compare(0, 9, "<![CDATA[") == 0){
+                const auto end = in.find("]]>", pos + 9);
+                return end == std::string_view::npos ? end : end + 3;
+            }
+        }else if(rest[1] == '?'){
+            const auto end = in.find("?>", pos + 2);
+            return end == std::string_view::npos ? end : end + 2;
+        }
+        // tags and declarations end at the first '>' outside of a quoted value
+        std::size_t i = findFirstOf<tag_delimiter_set>(in, pos + 1);
+        while(i != std::string_view::npos && in[i] != '>'){
+            const auto close = in.find(in[i], i + 1);
+            if(close == std::string_view::npos){
+                return close;
+            }
+            i = findFirstOf<tag_delimiter_set>(in, close + 1);
+        }
+        return i == std::string_view::npos ? i : i + 1;
+    }
+
+    // Where markupEnd() stopped in a markup that isn't complete yet.
+    struct markup_scan{
+        std::size_t from = 0;// searching goes on from here
+        char quote = 0;// the quote of the attribute value the search stopped in, 0 outside of one
+    };
+    // markupEnd() for input that grows between calls, e.g. a buffer being filled by short reads. s keeps what the calls
+    // on the shorter input already searched, so every byte is searched once. s is reset once the markup is complete.
+    [[nodiscard]] inline std::size_t markupEnd(const std::string_view in, const std::size_t pos, markup_scan& s) noexcept {
+        auto incomplete = [&s](const std::size_t from) noexcept {
+            s.from = from;
+            return std::string_view::npos;
+        };
+        auto complete = [&s](const std::size_t end) noexcept {
+            s = {};
+            return end;
+        };
+        // the terminator can straddle the end of the input, so its first bytes are searched again
+        auto until = [&](const std::string_view terminator, const std::size_t start){
+            const std::size_t from = std::max(start, s.from);
+            const auto end = in.find(terminator, from);
+            if(end == std::string_view::npos){
+                return incomplete(std::max(from, in.size() - (terminator.size() - 1)));
+            }
+            return complete(end + terminator.size());
+        };
+        if(in[pos] != '<'){
+            const auto end = in.find('<', std::max(pos, s.from));
+            return end == std::string_view::npos ? incomplete(in.size()) : complete(end);
+        }
+        const std::string_view rest = in.substr(pos);
+        if(rest.size() < 2){
+            return std::string_view::npos;
+        }
+        if(rest[1] == '!'){
+            if(rest.size() < 4 && std::string_view("<!--").substr(0, rest.size()) == rest){
+                return std::string_view::npos;
+            }
+            if(rest.compare(0, 4, "<!--") == 0){
+                return until("-->", pos + 4);
+            }
+            if(rest.size() < 9 && std::string_view("<![CDATA[").substr(0, rest.size()) == rest){
+                return std::string_view::npos;
+            }
+            if(rest.compare(0, 9, "<![CDATA[") == 0){
+                return until("]]>", pos + 9);
+            }
+        }else if(rest[1] == '?'){
+            return until("?>", pos + 2);
+        }
+        std::size_t i;
+        if(s.quote){
+            const auto close = in.find(s.quote, s.from);
+            if(close == std::string_view::npos){
+                return incomplete(in.size());
+            }
+            s.quote = 0;
+            i = findFirstOf<tag_delimiter_set>(in, close + 1);
+        }else{
+            i = findFirstOf<tag_delimiter_set>(in, std::max(pos + 1, s.from));
+        }
+        while(i != std::string_view::npos && in[i] != '>'){
+            const auto close = in.find(in[i], i + 1);
+            if(close == std::string_view::npos){
+                s.quote = in[i];
+                return incomplete(in.size());
+            }
+            i = findFirstOf<tag_delimiter_set>(in, close + 1);
+        }
+        return i == std::string_view::npos ? incomplete(in.size()) : complete(i + 1);
+    }
+
+    // Splits the markup in[pos, end) returned by markupEnd() into its parts.
+    [[nodiscard]] inline markup classifyMarkup(const std::string_view in, const std::size_t pos, const std::size_t end){
+        const std::string_view raw = in.substr(pos, end - pos);
+        if(raw[0] != '<'){
+            return {markup_type::text, {}, raw};
+        }
+        if(raw[1] == '!'){
+            if(raw.compare(0, 4, "<!--") == 0){
+                return {markup_type::comment, {}, raw.substr(4, raw.size() - 7)};
+            }
+            if(raw.compare(0, 9, "<![CDATA[") == 0){
+                return {markup_type::cdata, {}, raw.substr(9, raw.size() - 12)};
+            }
+            return {markup_type::declaration, {}, raw.substr(2, raw.size() - 3)};
+        }
+        if(raw[1] == '?'){
+            const std::string_view body = raw.substr(2, raw.size() - 4);
+            return {markup_type::processing_instruction, body.substr(0, findFirstOf<whitespace_set>(body)), body};
+        }
+
+        markup m{markup_type::start_tag, {}, {}};
+        std::string_view inner = raw.substr(1, raw.size() - 2);
+        if(!inner.empty() && inner[0] == '/'){
+            m.type = markup_type::end_tag;
+            inner.remove_prefix(1);
+        }else if(!inner.empty() && inner.back() == '/'){
+            m.type = markup_type::empty_tag;
+            inner.remove_suffix(1);
+        }
+        const std::size_t n = std::min(findFirstOf<whitespace_set>(inner), inner.size());
+        if(n == 0){
+            throw std::runtime_error("Missing tag name");
+        }
+        m.name = inner.substr(0, n);
+        m.body = inner.substr(n);
+        return m;
+    }
+
+    // Reads the next name="value" pair from the attribute span of a tag and advances the span past it.
+    // Attributes without a value are reported with an empty value.
+    [[nodiscard]] inline bool nextAttribute(std::string_view& span, std::string_view& name, std::string_view& value){
+        std::size_t i = findFirstNotOf<whitespace_set>(span);
+        if(i == std::string_view::npos){
+            span = {};
+            return false;
+        }
+        const std::size_t nameStart = i;
+        i = std::min(findFirstOf<attribute_name_end_set>(span, i), span.size());
+        name = span.substr(nameStart, i - nameStart);
+        value = {};
+        while(i < span.size() && isSpace(span[i])){
+            ++i;
+        }
+        if(i < span.size() && span[i] == '='){
+            ++i;
+            while(i < span.size() && isSpace(span[i])){
+                ++i;
+            }
+            if(i < span.size() && (span[i] == '"' || span[i] == '\'')){
+                const char quote = span[i++];
+                const auto close = span.find(quote, i);
+                if(close == std::string_view::npos){
+                    throw std::runtime_error("Unterminated value of attribute " + std::string(name));
+                }
+                value = span.substr(i, close - i);
+                i = close + 1;
+            }else{
+                const std::size_t valueStart = i;
+                i = std::min(findFirstOf<whitespace_set>(span, i), span.size());
+                value = span.substr(valueStart, i - valueStart);
+            }
+        }
+        span.remove_prefix(i);
+        return true;
+    }
+
+    // Whether a value read by nextAttribute() has no '"', which only values that weren't in double quotes can hold.
+    [[nodiscard]] inline bool fitsDoubleQuotes(const std::string_view value) noexcept {
+        return value.empty() || value.data()[-1] == '"' || value.find('"') == std::string_view::npos;
+    }
+
+    // Text and comment values are stored with every whitespace run collapsed into a single space and trimmed,
+    // which matches the values the token engine produces by joining its identifiers.
+    // Writes the collapsed form of raw to out, which needs room for raw.size() characters, and returns its length.
+    inline std::size_t collapseWhitespace(const std::string_view raw, char* out) noexcept {
+        std::size_t n = 0;
+        std::size_t i = findFirstNotOf<whitespace_set>(raw);
+        while(i != std::string_view::npos){
+            // copy the whole word at once, then skip the whitespace run after it
+            const std::size_t end = std::min(findFirstOf<whitespace_set>(raw, i), raw.size());
+            if(n != 0){
+                out[n++] = ' ';
+            }
+            std::memcpy(out + n, raw.data() + i, end - i);
+            n += end - i;
+            i = findFirstNotOf<whitespace_set>(raw, end);
+        }
+        return n;
+    }
+    [[nodiscard]] inline std::string collapseWhitespace(const std::string_view raw){
+        std::string out(raw.size(), '\0');
+        out.resize(collapseWhitespace(raw, out.data()));
+        return out;
+    }
+    [[nodiscard]] inline std::string_view trimSpace(std::string_view s) noexcept {
+        while(!s.empty() && isSpace(s.front())){
+            s.remove_prefix(1);
+        }
+        while(!s.empty() && isSpace(s.back())){
+            s.remove_suffix(1);
+        }
+        return s;
+    }
+    // True when a trimmed run has no whitespace other than single spaces, so it can be kept as a slice of the input.
+    [[nodiscard]] inline bool isCollapsed(const std::string_view trimmed) noexcept {
+        return findFirstOf<line_space_set>(trimmed) == std::string_view::npos && trimmed.find("  ") == std::string_view::npos;
+    }
+
+    // Decodes the reference at the start of s (which starts with '&') into out, returns the characters it takes up in s
+    // and sets length to the bytes written. Returns 0 for anything that isn't a predefined entity or a valid character reference.
+    [[nodiscard]] inline std::size_t decodeReference(const std::string_view s, char (&out)[4], std::size_t& length) noexcept {
+        const std::size_t semicolon = s.substr(0, 12).find(';');
+        if(semicolon == std::string_view::npos || semicolon < 3){
+            return 0;
+        }
+        const std::string_view body = s.substr(1, semicolon - 1);
+        length = 1;
+        if(body[0] != '#'){
+            constexpr std::pair<std::string_view, char> entities[] = {{"lt", '<'}, {"gt", '>'}, {"amp", '&'}, {"quot", '"'}, {"apos", '\''}};
+            for(const auto& [name, c] : entities){
+                if(body == name){
+                    out[0] = c;
+                    return semicolon + 1;
+                }
+            }
+            return 0;
+        }
+        const bool hex = body[1] == 'x';
+        const std::string_view digits = body.substr(hex ? 2 : 1);
+        if(digits.empty()){
+            return 0;
+        }
+        std::uint32_t code = 0;
+        for(const char c : digits){
+            std::uint32_t d;
+            if(c >= '0' && c <= '9'){
+                d = static_cast<std::uint32_t>(c - '0');
+            }else if(hex && (c | 0x20) >= 'a' && (c | 0x20) <= 'f'){
+                d = static_cast<std::uint32_t>((c | 0x20) - 'a' + 10);
+            }else{
+                return 0;
+            }
+            code = code * (hex ? 16 : 10) + d;// at most 9 digits, so this can't overflow
+        }
+        if(code == 0 || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)){
+            return 0;
+        }
+        // UTF-8, never longer than the reference it replaces
+        if(code < 0x80){
+            out[0] = static_cast<char>(code);
+        }else if(code < 0x800){
+            out[0] = static_cast<char>(0xC0 | code >> 6);
+            out[1] = static_cast<char>(0x80 | (code & 0x3F));
+            length = 2;
+        }else if(code < 0x10000){
+            out[0] = static_cast<char>(0xE0 | code >> 12);
+            out[1] = static_cast<char>(0x80 | (code >> 6 & 0x3F));
+            out[2] = static_cast<char>(0x80 | (code & 0x3F));
+            length = 3;
+        }else{
+            out[0] = static_cast<char>(0xF0 | code >> 18);
+            out[1] = static_cast<char>(0x80 | (code >> 12 & 0x3F));
+            out[2] = static_cast<char>(0x80 | (code >> 6 & 0x3F));
+            out[3] = static_cast<char>(0x80 | (code & 0x3F));
+            length = 4;
+        }
+        return semicolon + 1;
+    }
+    // Text and attribute values are stored with the predefined entities and character references replaced.
+    // Writes the decoded form of raw to out, which needs room for raw.size() characters and may be raw.data() itself,
+    // and returns its length. A '&' that doesn't start a reference is kept as it is.
+    inline std::size_t decodeEntities(const std::string_view raw, char* out) noexcept {
+        std::size_t n = 0;
+        std::size_t i = 0;
+        while(true){
+            const std::size_t amp = std::min(findFirstOf<reference_set>(raw, i), raw.size());
+            if(out + n != raw.data() + i){
+                std::memmove(out + n, raw.data() + i, amp - i);
+            }
+            n += amp - i;
+            if(amp == raw.size()){
+                return n;
+            }
+            char decoded[4];
+            std::size_t length = 0;
+            if(const std::size_t used = decodeReference(raw.substr(amp), decoded, length)){
+                std::memcpy(out + n, decoded, length);
+                n += length;
+                i = amp + used;
+            }else{
+                out[n++] = '&';
+                i = amp + 1;
+            }
+        }
+    }
+    [[nodiscard]] inline bool hasReferences(const std::string_view s) noexcept {
+        return findFirstOf<reference_set>(s) != std::string_view::npos;
+    }
+    [[nodiscard]] inline std::string decodeEntities(const std::string_view raw){
+        std::string out(raw);
+        out.resize(decodeEntities(out, out.data()));
+        return out;
+    }
+
+    // Processing instructions are normalized the same way the token engine rebuilds them:
+    // whitespace collapsed, no spaces around '=' and every pseudo attribute value in double quotes.
+    // Writes the normalized form of raw to out, which needs room for raw.size() + 1 characters, and returns its length.
+    inline std::size_t normalizeInstruction(const std::string_view raw, char* out) noexcept {
+        std::size_t n = 0;
+        bool pending = false;
+        for(std::size_t i = 0; i < raw.size(); ++i){
+            const char c = raw[i];
+            if(isSpace(c)){
+                pending = n != 0;
+                continue;
+            }
+            if(c == '='){
+                pending = false;
+                out[n++] = c;
+                continue;
+            }
+            if(pending && out[n - 1] != '='){
+                out[n++] = ' ';
+            }
+            pending = false;
+            if(c == '"' || c == '\''){
+                const auto close = raw.find(c, i + 1);
+                const auto end = close == std::string_view::npos ? raw.size() : close;
+                out[n++] = '"';
+                std::memcpy(out + n, raw.data() + i + 1, end - i - 1);
+                n += end - i - 1;
+                out[n++] = '"';// an unclosed value gets a closing quote, hence the extra character
+                i = end;
+            }else{
+                out[n++] = c;
+            }
+        }
+        return n;
+    }
+    [[nodiscard]] inline std::string normalizeInstruction(const std::string_view raw){
+        std::string out(raw.size() + 1, '\0');
+        out.resize(normalizeInstruction(raw, out.data()));
+        return out;
+    }
+
+    class lexer{
+        public:
+            explicit lexer(std::string_view in, std::size_t from = 0) noexcept : input(in), pos(from){}
+
+            // Moves to the next markup, returns false at the end of the input.
+            [[nodiscard]] bool next(markup& m){
+                if(pos >= input.size()){
+                    return false;
+                }
+                auto end = markupEnd(input, pos);
+                if(end == std::string_view::npos){
+                    if(input[pos] == '<'){
+                        throw std::runtime_error("Unexpected end of input");
+                    }
+                    end = input.size();// trailing text
+                }
+                m = classifyMarkup(input, pos, end);
+                pos = end;
+                return true;
+            }
+            [[nodiscard]] std::size_t position() const noexcept {
+                return pos;
+            }
+            // Continues at p, which has to be the start of a markup.
+            void seek(const std::size_t p) noexcept {
+                pos = p;
+            }
+        private:
+            std::string_view input;
+            std::size_t pos = 0;
+    };
+};
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(_WIN32)
+    // keep windows.h from defining min, max and most of its other macros in every file that includes the library
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// Read only memory mapping of a whole file, used as the backing store of a document loaded with load_mode::map.
+namespace miniXML::details{
+    class mapped_file{
+        public:
+            mapped_file() noexcept = default;
+            // populate asks the kernel to fault the whole file in up front (MAP_POPULATE where available),
+            // otherwise pages are read on first touch with sequential read ahead.
+            mapped_file(const std::string& filepath, const bool populate){
+#if defined(_WIN32)
+                file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+                if(file == INVALID_HANDLE_VALUE){
+                    throw std::runtime_error("Failed to open file");
+                }
+                LARGE_INTEGER fileSize;
+                if(!GetFileSizeEx(file, &fileSize)){
+                    close();
+                    throw std::runtime_error("Failed to open file");
+                }
+                length = static_cast<std::size_t>(fileSize.QuadPart);
+                if(length == 0){
+                    return;
+                }
+                mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if(mapping){
+                    address = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                }
+                if(!address){
+                    close();
+                    throw std::runtime_error("Failed to map file");
+                }
+    #if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+                // PrefetchVirtualMemory is in Windows 8 and later, older targets read pages on first touch
+                if(populate){
+                    WIN32_MEMORY_RANGE_ENTRY range{const_cast<char*>(address), length};
+                    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+                }
+    #else
+                (void)populate;
+    #endif
+#else
+                const int fd = ::open(filepath.c_str(), O_RDONLY);
+                if(fd < 0){
+                    throw std::runtime_error("Failed to open file");
+                }
+                struct stat info;
+                if(::fstat(fd, &info) != 0){
+                    ::close(fd);
+                    throw std::runtime_error("Failed to open file");
+                }
+                length = static_cast<std::size_t>(info.st_size);
+                if(length == 0){
+                    ::close(fd);
+                    return;
+                }
+                int flags = MAP_PRIVATE;
+    #if defined(MAP_POPULATE)
+                if(populate){
+                    flags |= MAP_POPULATE;
+                }
+    #endif
+                void* p = ::mmap(nullptr, length, PROT_READ, flags, fd, 0);
+                ::close(fd);// the mapping keeps its own reference to the file
+                if(p == MAP_FAILED){
+                    length = 0;
+                    throw std::runtime_error("Failed to map file");
+                }
+                address = static_cast<const char*>(p);
+                ::madvise(p, length, MADV_SEQUENTIAL);
+                if(populate){
+                    ::madvise(p, length, MADV_WILLNEED);
+                }
+#endif
+            }
+            mapped_file(const mapped_file&) = delete;
+            mapped_file& operator=(const mapped_file&) = delete;
+            mapped_file(mapped_file&& other) noexcept {
+                swap(other);
+            }
+            mapped_file& operator=(mapped_file&& other) noexcept {
+                if(this != &other){
+                    close();
+                    swap(other);
+                }
+                return *this;
+            }
+            ~mapped_file(){
+                close();
+            }
+
+            [[nodiscard]] std::string_view view() const noexcept {
+                return address ? std::string_view(address, length) : std::string_view();
+            }
+            void close() noexcept {
+#if defined(_WIN32)
+                if(address){
+                    UnmapViewOfFile(address);
+                }
+                if(mapping){
+                    CloseHandle(mapping);
+                }
+                if(file != INVALID_HANDLE_VALUE){
+                    CloseHandle(file);
+                }
+                mapping = nullptr;
+                file = INVALID_HANDLE_VALUE;
+#else
+                if(address){
+                    ::munmap(const_cast<char*>(address), length);
+                }
+#endif
+                address = nullptr;
+                length = 0;
+            }
+        private:
+            const char* address = nullptr;
+            std::size_t length = 0;
+#if defined(_WIN32)
+            HANDLE file = INVALID_HANDLE_VALUE;
+            HANDLE mapping = nullptr;
+#endif
+
+            void swap(mapped_file& other) noexcept {
+                std::swap(address, other.address);
+                std::swap(length, other.length);
+#if defined(_WIN32)
+                std::swap(file, other.file);
+                std::swap(mapping, other.mapping);
+#endif
+            }
+    };
+};
\ No newline at end of file
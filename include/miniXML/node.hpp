@@ -4,23 +4,96 @@
 #include <unordered_map>
 #include <optional>
 #include <algorithm>
+#include <string_view>
+#include <utility>
 #include "types.hpp"
+#include "arena.hpp"
+#include "xml_string.hpp"
+#include "attribute_list.hpp"
+#include "symbol_table.hpp"
+#include "hash.hpp"
 
 // Main tree implementation.
 namespace miniXML{  
+    class node;
+    class document;
+    class compact_document;
+
+    namespace details{
+        // The parts of a node of a lazily parsed document that are parsed on first access, see parse_engine::lazy.
+        // Lives in the document's arena, the views point into its input.
+        struct lazy_content{
+            document* owner;
+            std::string_view attributes;// the attributes of the start tag
+            std::string_view children;// everything between the start and the end tag
+            bool attributesPending;
+            bool childrenPending;
+        };
+
+        // Deletes heap nodes, and only destroys nodes that live in a document arena.
+        // Converts from std::default_delete so std::unique_ptr<node> can be handed to appendChild().
+        template<class Output>
+        class basic_serializer;
+
+        struct node_deleter{
+            node_deleter() noexcept = default;
+            node_deleter(const std::default_delete<node>&) noexcept {}
+            void operator()(node* n) const noexcept;
+        };
+    }
+
+    using node_ptr = std::unique_ptr<node, details::node_deleter>;
+
     class node{
         public:
+            using child_list = std::vector<node_ptr, details::arena_allocator<node_ptr>>;
+            using attribute_list = details::attribute_list;
+
             //constructor
-            node(details::node_type t, std::string v) : type(t), value(std::move(v)){}
+            node(details::node_type t, std::string_view v) : type(t), value(v){}
+            // Destroys the subtree bottom up, walking it through the parent links instead of recursing,
+            // so there is no limit on its depth. Every child is empty by the time it is destroyed.
+            ~node(){
+                node* n = this;
+                while(!n->children.empty() || n != this){
+                    if(n->children.empty()){
+                        n = n->parent;
+                        n->children.pop_back();
+                    }else if(!n->children.back()->children.empty()){
+                        n = n->children.back().get();
+                    }else{
+                        n->children.pop_back();
+                    }
+                }
+            }
+            node(const node&) = delete;
+            node& operator=(const node&) = delete;
+            // Nodes made one at a time come from the heap and are counted in the document stats, arena nodes are placed.
+            [[nodiscard]] static void* operator new(const std::size_t size){
+                details::countAllocation(size);
+                return ::operator new(size);
+            }
+            [[nodiscard]] static void* operator new(std::size_t, void* place) noexcept {
+                return place;
+            }
+            static void operator delete(void* p) noexcept {
+                ::operator delete(p);
+            }
+            static void operator delete(void*, void*) noexcept {}
 
             //getters
             details::node_type getType() const noexcept {
                 return type;
             }
-            const std::string& getValue() const noexcept {
-                return value;
+            std::string_view getValue() const noexcept {
+                return value.view();
+            }
+            // Id of the element name in the document's symbol table, no_symbol for nodes that weren't parsed.
+            details::symbol_id getSymbol() const noexcept {
+                return symbolId;
             }
-            const std::vector<std::unique_ptr<node>>& getChildren() const {
+            const child_list& getChildren() const {
+                loadChildren();
                 return children;
             }
             node* getParent() noexcept {
@@ -29,94 +102,64 @@ namespace miniXML{
             const node* getParent() const noexcept {
                 return parent;
             }
-            const std::unordered_map<std::string, std::string>& getAttributes() const{
+            const attribute_list& getAttributes() const{
+                loadAttributes();
                 return attributes;
             }
+            // Hash of the subtree: the type and value of every node, the attributes in order and the children in order.
+            // Equal subtrees hash equal, so a changed hash means a changed subtree. It is cached, the modifiers clear it on
+            // the node and its ancestors, so after a change only the path to the root is hashed again.
+            // Like the child index, computing it modifies the nodes, see document::computeHashes() to hash a tree in parallel.
+            [[nodiscard]] std::uint64_t getHash() const;
             //setters
             void setType(const details::node_type n) noexcept {
                 type = n;
+                invalidateHash();
             }
             void setValue(const std::string_view n){
-                value.assign(n);
-            }
-            [[nodiscard]] std::string toString(int depth = 0) const {
-                const std::string ind(depth * 2, ' ');
-                std::string xml;
-                xml += ind;
-                switch (type){
-                    case details::node_type::TEXT_NODE:{
-                        xml += value + '\n';
-                        break;
-                    }
-                    case details::node_type::PROCESSING_INSTRUCTION_NODE:{
-                        xml += "<?" + value + "?>\n";
-                        break;
-                    }
-                    case details::node_type::COMMENT_NODE:{
-                        std::string comment = value;
-                        if(!comment.empty()){
-                            comment.pop_back();// pop the whitespace added in the parsing process
-                        }
-                        xml += "<!--" + comment + "-->\n";
-                        break;
-                    }
-                    case details::node_type::ELEMENT_NODE:{
-                        std::string element = "<" + value;
-
-                        for(const auto& a : attributes){
-                            element += " " + a.first + "=\"";
-                            element += a.second;
-                            element += "\"";
-                        }
-            
-                        if(children.empty()){
-                            element += "/>\n";
-                            xml += element;
-                            return xml;
-                        }
-
-                        element += ">\n";
-
-                        for(const auto& c : children){
-                            element += c->toString(depth + 1);
-                        }
-
-                        element += ind +"</" + value + ">\n";
-                        xml += element;
-
-                        break;
-                    }
-                    default:{
-                        for(const auto& c : children){
-                            xml += c->toString(depth); 
-                        }
-                        break;
-                    }    
+                invalidateHash();
+                if(parent){
+                    parent->index.reset();// its index is keyed by the old value
                 }
-                return xml;
+                value.assign(n);
+                symbolId = details::no_symbol;
             }
+            // Serializes the node and its subtree, see writer.hpp.
+            [[nodiscard]] std::string toString(int depth = 0, details::output_format format = details::output_format::indented) const;
             void appendAttribute(const std::string_view key, const std::string_view value){
-                attributes.insert_or_assign(std::string(key), std::string(value));
+                loadAttributes();
+                plainAttributes = false;
+                invalidateHash();
+                attributes.insert_or_assign(details::xml_string(key), details::xml_string(value));
             }
-            node* appendChild(std::unique_ptr<node> n){
+            node* appendChild(node_ptr n){
+                loadChildren();
+                invalidateHash();
                 n->parent = this;
                 children.push_back(std::move(n));
-                return children.back().get();
+                node* added = children.back().get();
+                if(index){
+                    index->byValue[added->value.view()].push_back(added);
+                }
+                return added;
             }
-            [[nodiscard]] bool deleteAttribute(const std::string& key){
+            [[nodiscard]] bool deleteAttribute(const std::string_view key){
+                loadAttributes();
                 auto it = attributes.find(key);
                 if(it == attributes.end()){
                     return false;
                 }
                 attributes.erase(it);
+                invalidateHash();
                 return true;
             }
             [[nodiscard]] bool deleteChild(const node* n){
                 if(!n){
                     return false;
                 }
+                loadChildren();
 
-                auto it = std::find_if(children.begin(), children.end(), [n](const std::unique_ptr<node>& c){
+                auto it = std::find_if(children.begin(), children.end(), [n](const node_ptr& c){
                     return n == c.get();
                 });
                 
@@ -124,58 +167,91 @@ namespace miniXML{
                     return false;
                 }
 
+                if(index){
+                    auto entry = index->byValue.find((*it)->value.view());
+                    auto& same = entry->second;
+                    same.erase(std::find(same.begin(), same.end(), n));
+                    if(same.empty()){
+                        index->byValue.erase(entry);
+                    }else if(entry->first.data() == (*it)->value.view().data()){
+                        // the key is a view of the value of the child going away
+                        auto handle = index->byValue.extract(entry);
+                        handle.key() = handle.mapped().front()->value.view();
+                        index->byValue.insert(std::move(handle));
+                    }
+                }
                 (*it)->parent = nullptr;
                 children.erase(it);
+                invalidateHash();
                 return true;
             }
             [[nodiscard]] bool deleteFromParent(){
                 return parent ? parent->deleteChild(this) : false;
             }
             void clearChildren(){
+                if(pending){
+                    pending->childrenPending = false;
+                }
                 for(auto& c : children){
                     c->parent = nullptr;
                 }
                 children.clear();
+                index.reset();
+                invalidateHash();
             }
             void clearAttributes(){
+                if(pending){
+                    pending->attributesPending = false;
+                }
                 attributes.clear();
+                invalidateHash();
             }
-            [[nodiscard]] std::optional<std::string> getAttribute(const std::string& key) const{
+            // The returned view stays valid until the attribute is changed or deleted.
+            [[nodiscard]] std::optional<std::string_view> getAttribute(const std::string_view key) const{
+                loadAttributes();
                 auto it = attributes.find(key);
                 if(it == attributes.end()){
                     return std::nullopt;
                 }
-                return it->second;
+                return it->second.view();
             }
             [[nodiscard]] node* findChild(const details::node_type t){
-                const auto it = std::find_if(children.begin(), children.end(), [t](const std::unique_ptr<node>&n){
+                loadChildren();
+                const auto it = std::find_if(children.begin(), children.end(), [t](const node_ptr&n){
                     return n->type == t;
                 });
 
                 return it != children.end() ? it->get() : nullptr;
             }
             [[nodiscard]] const node* findChild(const details::node_type t) const {
-                const auto it = std::find_if(children.begin(), children.end(), [t](const std::unique_ptr<node>&n){
+                loadChildren();
+                const auto it = std::find_if(children.begin(), children.end(), [t](const node_ptr&n){
                     return n->type == t;
                 });
 
                 return it != children.end() ? it->get() : nullptr;
             }
-            [[nodiscard]] node* findChild(const std::string& t){
-                const auto it = std::find_if(children.begin(), children.end(), [t](const std::unique_ptr<node>&n){
-                    return n->value == t;
-                });
-
-                return it != children.end() ? it->get() : nullptr;
+            // Lookups by value scan the children, nodes with many children build an index on the first lookup instead.
+            // Building the index modifies the node, so lookups on one node can't run on several threads at once.
+            [[nodiscard]] node* findChild(const std::string_view v){
+                return const_cast<node*>(std::as_const(*this).findChild(v));
             }
-            [[nodiscard]] const node* findChild(const std::string& t) const {
-                const auto it = std::find_if(children.begin(), children.end(), [t](const std::unique_ptr<node>&n){
-                    return n->value == t;
+            [[nodiscard]] const node* findChild(const std::string_view v) const {
+                loadChildren();
+                if(const auto* same = indexed(v)){
+                    return same->empty() ? nullptr : same->front();
+                }
+                const auto it = std::find_if(children.begin(), children.end(), [v](const node_ptr& n){
+                    return n->value == v;
                 });
 
                 return it != children.end() ? it->get() : nullptr;
             }
-            [[nodiscard]] std::vector<node*> findChildren(const std::string& v){
+            [[nodiscard]] std::vector<node*> findChildren(const std::string_view v){
+                loadChildren();
+                if(const auto* same = indexed(v)){
+                    return *same;
+                }
                 std::vector<node*> results;
                 
                 for(const auto& c : children){
@@ -185,17 +261,40 @@ namespace miniXML{
                 }
                 return results;
             }
-            [[nodiscard]] std::vector<const node*> findChildren(const std::string& v) const {
-                std::vector<const node*> results;
-                
+            [[nodiscard]] std::vector<const node*> findChildren(const std::string_view v) const {
+                const auto found = const_cast<node*>(this)->findChildren(v);
+                return std::vector<const node*>(found.begin(), found.end());
+            }
+            // Lookups by a symbol of the document the node belongs to, see document::findSymbol().
+            // Parsed elements are matched by id, other nodes by value.
+            [[nodiscard]] node* findChild(const details::symbol& s){
+                return const_cast<node*>(std::as_const(*this).findChild(s));
+            }
+            [[nodiscard]] const node* findChild(const details::symbol& s) const {
+                loadChildren();
+                const auto it = std::find_if(children.begin(), children.end(), [&s](const node_ptr& n){
+                    return n->matches(s);
+                });
+
+                return it != children.end() ? it->get() : nullptr;
+            }
+            [[nodiscard]] std::vector<node*> findChildren(const details::symbol& s){
+                loadChildren();
+                std::vector<node*> results;
+
                 for(const auto& c : children){
-                    if(c->value == v){
+                    if(c->matches(s)){
                         results.push_back(c.get());
                     }
                 }
                 return results;
             }
+            [[nodiscard]] std::vector<const node*> findChildren(const details::symbol& s) const {
+                const auto found = const_cast<node*>(this)->findChildren(s);
+                return std::vector<const node*>(found.begin(), found.end());
+            }
             [[nodiscard]] std::vector<node*> findChildren(details::node_type t){
+                loadChildren();
                 std::vector<node*> results;
                 
                 for(const auto& c : children){
@@ -206,6 +305,7 @@ namespace miniXML{
                 return results;
             }
             [[nodiscard]] std::vector<const node*> findChildren(details::node_type t) const {
+                loadChildren();
                 std::vector<const node*> results;
                 
                 for(const auto& c : children){
@@ -217,11 +317,124 @@ namespace miniXML{
             }
         private:
             details::node_type type;
-            std::string value;
-            std::vector<std::unique_ptr<node>> children;
-            std::unordered_map<std::string, std::string> attributes;
+            details::symbol_id symbolId = details::no_symbol;
+            bool inArena = false;
+            bool plainAttributes = false;// set by the parsers when no attribute value needs escaping
+            details::xml_string value;
+            child_list children;
+            attribute_list attributes;
             node* parent = nullptr;
+            mutable details::lazy_content* pending = nullptr;// only set on nodes of a lazily parsed document
+            mutable std::uint64_t hash = 0;// of the subtree, 0 until getHash() computes it
+
+            // Parses what a lazily parsed node hasn't parsed yet. Like the child index, this modifies the node on the first
+            // access, so the first access to a lazy node can't happen on several threads at once.
+            void loadChildren() const {
+                if(pending && pending->childrenPending){
+                    expandChildren();
+                }
+            }
+            void loadAttributes() const {
+                if(pending && pending->attributesPending){
+                    expandAttributes();
+                }
+            }
+            //defined in parser.hpp
+            void expandChildren() const;
+            void expandAttributes() const;
+
+            // A node only has a hash when its whole subtree has one, so clearing stops at the first ancestor without one.
+            void invalidateHash() noexcept {
+                for(node* n = this; n && n->hash; n = n->parent){
+                    n->hash = 0;
+                }
+            }
+            // The hash of this node from its own content and the hashes of its children, which are already computed.
+            [[nodiscard]] std::uint64_t combineHash() const {
+                std::uint64_t h = details::hashBytes(value.view(), static_cast<std::uint64_t>(type) + 1);
+                h = details::mixHash(h, attributes.size());
+                for(const auto& a : attributes){
+                    h = details::hashBytes(a.second.view(), details::hashBytes(a.first.view(), h));
+                }
+                h = details::mixHash(h, children.size());
+                for(const auto& c : children){
+                    h = details::mixHash(h, c->hash);
+                }
+                return h ? h : 1;// 0 means not computed
+            }
+
+            [[nodiscard]] bool matches(const details::symbol& s) const noexcept {
+                return symbolId != details::no_symbol ? symbolId == s.id : value == s.name;
+            }
+
+            // Children by value, in document order.
+            struct child_index{
+                std::unordered_map<std::string_view, std::vector<node*>> byValue;
+            };
+            mutable std::unique_ptr<child_index> index;
+            // Nodes with fewer children are searched linearly, which is faster than hashing the key.
+            static constexpr std::size_t indexThreshold = 32;
+
+            // Children whose value is v when the node is indexed (building the index if it's due), null otherwise.
+            [[nodiscard]] const std::vector<node*>* indexed(const std::string_view v) const {
+                if(!index){
+                    if(children.size() < indexThreshold){
+                        return nullptr;
+                    }
+                    index = std::make_unique<child_index>();
+                    for(const auto& c : children){
+                        index->byValue[c->value.view()].push_back(c.get());
+                    }
+                }
+                static const std::vector<node*> none;
+                const auto it = index->byValue.find(v);
+                return it != index->byValue.end() ? &it->second : &none;
+            }
+
+            // Used by document for nodes placed in its arena, value is borrowed and the containers allocate from the arena.
+            node(details::node_type t, details::xml_string v, details::arena& a)
+                : type(t), inArena(true), value(std::move(v)), children(details::arena_allocator<node_ptr>(&a)),
+                  attributes(attribute_list::allocator_type(&a)){}
 
             friend class document;
+            friend class compact_document;
+            friend struct details::node_deleter;
+            template<class Output>
+            friend class details::basic_serializer;
     };
-};
\ No newline at end of file
+
+    // Walks down to the nodes without a hash and fills them in bottom up, without recursing.
+    inline std::uint64_t node::getHash() const {
+        if(hash){
+            return hash;
+        }
+        std::vector<std::pair<const node*, std::size_t>> open{{this, 0}};// node, next child to look at
+        while(!open.empty()){
+            const node* n = open.back().first;
+            n->loadAttributes();
+            const auto& kids = n->getChildren();
+            std::size_t next = open.back().second;
+            while(next < kids.size() && kids[next]->hash){
+                ++next;
+            }
+            if(next < kids.size()){
+                open.back().second = next + 1;
+                open.emplace_back(kids[next].get(), 0);
+                continue;
+            }
+            n->hash = n->combineHash();
+            open.pop_back();
+        }
+        return hash;
+    }
+
+    inline void details::node_deleter::operator()(node* n) const noexcept {
+        if(n->inArena){
+            n->~node();
+        }else{
+            delete n;
+        }
+    }
+};
+
+#include "writer.hpp"
\ No newline at end of file
@@ -1,14 +1,13 @@
 #pragma once
 #include "document.hpp"
-// Internal implementation of miniXML::document parsing and serialization.
+// Internal implementation of miniXML::document parsing.
 // Separated to keep document.hpp minimal and stable.
 namespace miniXML{
     inline void document::tokenize(){
-        int i = 0;
-        while(i < content.size()){
-            std::string s;
+        std::size_t i = 0;
+        while(i < input.size()){
             char quote;
-            switch (content[i]){
+            switch (input[i]){
                 case '<':
                     tokens.push_back({details::token_type::lt, "<"});
                     i++;
@@ -21,14 +20,13 @@ namespace miniXML{
                     tokens.push_back({details::token_type::equals, "="});
                     i++;
                     break;
-                case '"': case '\'':
-                    quote = content[i++];
-                    while(i < content.size() && content[i] != quote){
-                        s += content[i++];
-                    }
-                    ++i;
-                    tokens.push_back({details::token_type::string, s}); 
+                case '"': case '\'':{
+                    quote = input[i++];
+                    const auto close = std::min(input.find(quote, i), input.size());
+                    tokens.push_back({details::token_type::string, std::string(input.substr(i, close - i))});
+                    i = close + 1;
                     break;
+                }
                 case '/':
                     tokens.push_back({details::token_type::slash, "/"});
                     i++;
@@ -46,13 +44,12 @@ namespace miniXML{
                     i++;
                     break;
                 default:
-                    if(std::isspace(static_cast<unsigned char>(content[i]))){
-                        i++;
+                    if(details::isSpace(input[i])){
+                        i = std::min(details::findFirstNotOf<details::whitespace_set>(input, i), input.size());
                     }else{
-                        while(i < content.size() && !std::isspace(content[i]) && content[i] != '<' && content[i] != '>' && content[i] != '=' && content[i] != '/' && content[i] != '?' && content[i] != '-'){
-                            s += content[i++];
-                        }
-                        tokens.push_back({details::token_type::identifier, s});
+                        const auto end = std::min(details::findFirstOf<details::identifier_end_set>(input, i), input.size());
+                        tokens.push_back({details::token_type::identifier, std::string(input.substr(i, end - i))});
+                        i = end;
                     }
                     break;
 
@@ -60,183 +57,461 @@ namespace miniXML{
         }
     }
 
+    // Builds the tree from the token vector. Open elements are kept on an explicit stack instead of the call stack,
+    // so the nesting depth is only bounded by maxDepth.
     inline void document::buildTree(){
-        auto i{0};
+        std::size_t i = 0;
+        node* current = &root;
+        std::size_t depth = 0;
         while(i < tokens.size()){
-            if(i + 1 < tokens.size() && tokens[i].type == details::token_type::lt && tokens[i + 1].type == details::token_type::identifier){
-                auto child = parseElement(i);
-                if(child){
-                    root.appendChild(std::move(child));
-                }
-            }else if(i + 1 < tokens.size() && tokens[i].type == details::token_type::lt && tokens[i + 1].type == details::token_type::exclamation){
-                i += 4;// skip <!--
-                std::string comment;
-                while(i + 2 < tokens.size() && tokens[i].type != details::token_type::dash && tokens[i + 1].type != details::token_type::dash && tokens[i + 2].type != details::token_type::gt){
-                    comment += tokens[i++].value + " ";
-                }
-                i += 3;// skip -->
-                auto commentNode = std::make_unique<node>(details::node_type::COMMENT_NODE, comment);
-                root.appendChild(std::move(commentNode));
-            }else if(i + 1 < tokens.size() && tokens[i].type == details::token_type::lt && tokens[i + 1].type == details::token_type::question){
-                i += 2;// skip <?
-                std::string pi;
-                while(i + 1 < tokens.size() && tokens[i].type != details::token_type::question){
-                    if(tokens[i].type == details::token_type::identifier && tokens[i + 1].type == details::token_type::equals){
-                        pi += " " + tokens[i].value;
-                    }else if(tokens[i].type == details::token_type::equals){
-                        pi += tokens[i].value + "\"";
-                    }else if(tokens[i].type == details::token_type::string){
-                        pi += tokens[i].value + "\"";
-                    }else{
-                        pi += tokens[i].value;
+            const bool inElement = current != &root;
+            const bool markup = i + 1 < tokens.size() && tokens[i].type == details::token_type::lt;
+            if(inElement && i + 1 >= tokens.size()){
+                current = current->parent;// the input ended inside the element
+                --depth;
+            }else if(inElement && markup && tokens[i + 1].type == details::token_type::slash){
+                if(i + 2 < tokens.size() && tokens[i + 2].type == details::token_type::identifier){
+                    if(current->value != tokens[i + 2].value){
+                        throw std::runtime_error("Closing tag of " + current->value.str() + " doesn't match!");
                     }
-                    i++;
+                    i += 3;// skip </name
+                    if(i < tokens.size() && tokens[i].type == details::token_type::gt){
+                        i++;// skip >
+                    }
+                }
+                current = current->parent;
+                --depth;
+            }else if(markup && (tokens[i + 1].type == details::token_type::identifier || (inElement && tokens[i + 1].type == details::token_type::string))){
+                if(depth >= maxDepth){
+                    tooDeep();
                 }
-                auto piNode = std::make_unique<node>(details::node_type::PROCESSING_INSTRUCTION_NODE, pi);
-                root.appendChild(std::move(piNode));
+                bool empty = false;
+                node* element = current->appendChild(parseStartTag(i, empty));
+                if(!empty){
+                    current = element;
+                    ++depth;
+                }
+            }else if(inElement && i + 1 < tokens.size() && tokens[i].type == details::token_type::identifier && tokens[i + 1].type != details::token_type::dash){
+                std::string text;
+                while(i < tokens.size() && (tokens[i].type == details::token_type::string || tokens[i].type == details::token_type::identifier)){
+                    text += tokens[i++].value + ' ';
+                }
+                if(!text.empty()){
+                    text.pop_back();
+                }
+                text.resize(details::decodeEntities(text, text.data()));
+                current->appendChild(std::make_unique<node>(details::node_type::TEXT_NODE, text));
+            }else if(markup && tokens[i + 1].type == details::token_type::exclamation){
+                current->appendChild(parseComment(i));
+            }else if(markup && tokens[i + 1].type == details::token_type::question){
+                current->appendChild(parseInstruction(i));
             }else{
                 i++;// go on the next token
             }
         }
     }
 
-    inline std::unique_ptr<node> document::parseElement(int& i){
-        if(i + 1 >= tokens.size() || tokens[i].type != details::token_type::lt){
-            return nullptr;
-        }
-        ++i;
-
-        std::string name = tokens[i++].value;
-        auto element = std::make_unique<node>(details::node_type::ELEMENT_NODE, name);
+    // Parses <name attributes and the > or /> closing the tag, empty tells which one it was.
+    inline std::unique_ptr<node> document::parseStartTag(std::size_t& i, bool& empty){
+        ++i;// skip <
+        const details::symbol s = names.intern(tokens[i++].value);
+        auto element = std::make_unique<node>(details::node_type::ELEMENT_NODE, std::string_view());
+        element->value = details::xml_string::borrow(s.name);
+        element->symbolId = s.id;
         while(i + 1 < tokens.size() && tokens[i].type == details::token_type::identifier && tokens[i + 1].type == details::token_type::equals){
-            std::string attName = tokens[i++].value;
+            const std::string& attName = tokens[i++].value;
             ++i;// skip the =
-            std::string attValue = tokens[i++].value;
-            element->appendAttribute(attName, attValue);
+            element->attributes.insert_or_assign(details::xml_string::borrow(names.intern(attName).name), details::xml_string(details::decodeEntities(tokens[i++].value)));
         }
         if(i + 1 < tokens.size() && tokens[i].type == details::token_type::slash && tokens[i + 1].type == details::token_type::gt){
             i += 2;// skip />
-            return element;
-        }
-        if(i < tokens.size() && tokens[i].type == details::token_type::gt){
+            empty = true;
+        }else if(i < tokens.size() && tokens[i].type == details::token_type::gt){
             i++;
         }
-        if(i + 1 < tokens.size() && tokens[i].type == details::token_type::lt && tokens[i + 1].type == details::token_type::exclamation){
-            i += 4;// skip <!--
-            std::string comment;
-            while(i + 2 < tokens.size() && tokens[i].type != details::token_type::dash && tokens[i + 1].type != details::token_type::dash && tokens[i + 2].type != details::token_type::gt){
-                    comment += tokens[i++].value + " ";
+        return element;
+    }
+
+    inline std::unique_ptr<node> document::parseComment(std::size_t& i){
+        i += 4;// skip <!--
+        std::string comment;
+        while(i + 2 < tokens.size() && !(tokens[i].type == details::token_type::dash && tokens[i + 1].type == details::token_type::dash && tokens[i + 2].type == details::token_type::gt)){
+            comment += tokens[i++].value + " ";
+        }
+        if(!comment.empty()){
+            comment.pop_back();// drop the separator after the last word
+        }
+        i += 3;// skip -->
+        return std::make_unique<node>(details::node_type::COMMENT_NODE, comment);
+    }
+
+    inline std::unique_ptr<node> document::parseInstruction(std::size_t& i){
+        i += 2;// skip <?
+        std::string pi;
+        while(i + 1 < tokens.size() && tokens[i].type != details::token_type::question){
+            if(tokens[i].type == details::token_type::identifier && tokens[i + 1].type == details::token_type::equals){
+                pi += " " + tokens[i].value;
+            }else if(tokens[i].type == details::token_type::equals){
+                pi += tokens[i].value + "\"";
+            }else if(tokens[i].type == details::token_type::string){
+                pi += tokens[i].value + "\"";
+            }else{
+                pi += tokens[i].value;
             }
-            i += 3;// skip -->
-            auto commentNode = std::make_unique<node>(details::node_type::COMMENT_NODE, comment);
-            element->appendChild(std::move(commentNode));
+            i++;
         }
+        return std::make_unique<node>(details::node_type::PROCESSING_INSTRUCTION_NODE, pi);
+    }
 
-        while(i + 1 < tokens.size() && !(tokens[i].type == details::token_type::lt && tokens[i + 1].type == details::token_type::slash)){
-            if(i + 1 < tokens.size() && tokens[i].type == details::token_type::lt && (tokens[i + 1].type == details::token_type::identifier || tokens[i + 1].type == details::token_type::string)){
-                element->appendChild(parseElement(i));
-            }else if(i + 1 < tokens.size() && tokens[i].type == details::token_type::identifier && tokens[i + 1].type != details::token_type::dash){
-                std::string text;
-                while(i < tokens.size() && (tokens[i].type == details::token_type::string || tokens[i].type == details::token_type::identifier)){
-                    text += tokens[i++].value + ' ';
+    inline std::string_view document::collapse(details::arena& a, std::string_view raw){
+        const std::string_view trimmed = details::trimSpace(raw);
+        if(details::isCollapsed(trimmed)){
+            return trimmed;
+        }
+        char* out = static_cast<char*>(a.allocate(trimmed.size(), 1));
+        return {out, details::collapseWhitespace(trimmed, out)};
+    }
+    inline std::string_view document::decode(details::arena& a, const std::string_view raw){
+        if(!details::hasReferences(raw)){
+            return raw;
+        }
+        char* out = static_cast<char*>(a.allocate(raw.size(), 1));
+        return {out, details::decodeEntities(raw, out)};
+    }
+
+    // Parses every markup of the input that starts in [from, until) into f, allocating from a.
+    // Nothing here touches the document tree and names go through the locked symbol table, so ranges can be parsed on several threads at once.
+    inline void document::parseRange(fragment& f, details::arena& a, const std::size_t from, const std::size_t until){
+        details::lexer lex(input, from);
+        details::symbol_cache symbols(names);
+        details::markup m;
+        f.end = from;
+        auto place = [&f](node_ptr n){
+            if(f.open.empty()){
+                f.items.push_back({std::move(n), {}});
+                return f.items.back().n.get();
+            }
+            return f.open.back()->appendChild(std::move(n));
+        };
+        while(lex.position() < until && lex.next(m)){
+            switch (m.type){
+                case details::markup_type::start_tag:
+                case details::markup_type::empty_tag:{
+                    auto element = makeElement(a, symbols.intern(m.name));
+                    std::string_view name, value;
+                    // one scan over the whole tag instead of one per value, most tags have nothing to decode or escape
+                    const bool special = details::findFirstOf<details::tag_special_set>(m.body) != std::string_view::npos;
+                    bool plain = !special;
+                    while(details::nextAttribute(m.body, name, value)){
+                        plain = plain && details::fitsDoubleQuotes(value);
+                        element->attributes.insert_or_assign(details::xml_string::borrow(symbols.intern(name).name),
+                            details::xml_string::borrow(special ? decode(a, value) : value));
+                    }
+                    element->plainAttributes = plain;
+                    // the range may start inside other elements, stitch() adds their depth
+                    if(f.open.size() >= maxDepth){
+                        tooDeep();
+                    }
+                    node* placed = place(std::move(element));
+                    f.items.back().levels = std::max(f.items.back().levels, f.open.size() + 1);
+                    if(m.type == details::markup_type::start_tag){
+                        f.open.push_back(placed);
+                    }
+                    break;
                 }
-                if(!text.empty()){
-                    text.pop_back();
+                case details::markup_type::end_tag:{
+                    if(f.open.empty()){
+                        f.items.push_back({nullptr, m.name});// closes an element opened before the range
+                        break;
+                    }
+                    if(m.name != f.open.back()->value){
+                        throw std::runtime_error("Closing tag of " + f.open.back()->value.str() + " doesn't match!");
+                    }
+                    f.open.pop_back();
+                    break;
                 }
-                element->appendChild(std::make_unique<node>(details::node_type::TEXT_NODE, text));
-            }else if(i + 1 < tokens.size() && tokens[i].type == details::token_type::lt && tokens[i + 1].type == details::token_type::exclamation){
-                i += 4;//skip <!--
-                std::string comment;
-                while(i + 2 < tokens.size() && tokens[i].type != details::token_type::dash && tokens[i + 1].type != details::token_type::dash && tokens[i + 2].type != details::token_type::gt){
-                    comment += tokens[i++].value + " ";
-                }
-                i += 3;// skip -->
-                auto commentNode = std::make_unique<node>(details::node_type::COMMENT_NODE, comment);
-                element->appendChild(std::move(commentNode));
-            }else if(i + 1 < tokens.size() && tokens[i].type == details::token_type::lt && tokens[i + 1].type == details::token_type::question){
-                i += 2;// skip <?
-                std::string pi;
-                while(i + 1 < tokens.size() && tokens[i].type != details::token_type::question){
-                    if(tokens[i].type == details::token_type::identifier && tokens[i + 1].type == details::token_type::equals){
-                        pi += " " + tokens[i].value;
-                    }else if(tokens[i].type == details::token_type::equals){
-                        pi += tokens[i].value + "\"";
-                    }else if(tokens[i].type == details::token_type::string){
-                        pi += tokens[i].value + "\"";
-                    }else{
-                        pi += tokens[i].value;
+                case details::markup_type::text:{
+                    const std::string_view text = decode(a, collapse(a, m.body));
+                    if(!text.empty()){
+                        place(makeNode(a, details::node_type::TEXT_NODE, text));
                     }
-                    i++;
+                    break;
+                }
+                case details::markup_type::cdata:{
+                    place(makeNode(a, details::node_type::TEXT_NODE, m.body));
+                    break;
+                }
+                case details::markup_type::comment:{
+                    place(makeNode(a, details::node_type::COMMENT_NODE, collapse(a, m.body)));
+                    break;
+                }
+                case details::markup_type::processing_instruction:{
+                    char* out = static_cast<char*>(a.allocate(m.body.size() + 1, 1));
+                    place(makeNode(a, details::node_type::PROCESSING_INSTRUCTION_NODE, {out, details::normalizeInstruction(m.body, out)}));
+                    break;
+                }
+                default:
+                    break;// declarations such as <!DOCTYPE> aren't kept
+            }
+            f.end = lex.position();
+            if constexpr (details::stats_enabled){
+                ++f.markups;
+            }
+        }
+    }
+
+    // Attaches the top level items of f below current, which is depth elements deep, and returns the node that is current afterwards.
+    // depth is updated to the depth of that node.
+    inline node* document::stitch(node* current, std::size_t& depth, fragment& f){
+        for(auto& item : f.items){
+            if(!item.n){
+                if(current == &root){
+                    continue;// a stray closing tag, the token engine skips those as well
+                }
+                if(item.closing != current->value){
+                    throw std::runtime_error("Closing tag of " + current->value.str() + " doesn't match!");
                 }
-                auto piNode = std::make_unique<node>(details::node_type::PROCESSING_INSTRUCTION_NODE, pi);
-                element->appendChild(std::move(piNode));
+                current = current->parent;
+                --depth;
+            }else if(current == &root && item.n->type == details::node_type::TEXT_NODE){
+                continue;// text outside of the root element isn't part of the tree
             }else{
-                i++;
+                if(depth + item.levels > maxDepth){
+                    tooDeep();
+                }
+                current->appendChild(std::move(item.n));
             }
         }
-        
-        if(i + 2 < tokens.size() && tokens[i].type == details::token_type::lt && tokens[i + 1].type == details::token_type::slash && tokens[i + 2].type == details::token_type::identifier){
-            std::string closing_name = tokens[i + 2].value;
+        f.items.clear();
+        // the elements left open are already linked to each other, the outermost one was the last item
+        if(f.open.empty()){
+            return current;
+        }
+        depth += f.open.size();
+        return f.open.back();
+    }
+
+    // Builds the tree in one forward scan over the input, without going through the token vector.
+    inline void document::parseDirect(){
+        fragment& f = scratch;
+        f.items.clear();
+        f.open.clear();
+        f.markups = 0;
+        parseRange(f, memory, 0, input.size());
+        statistics.tokens += f.markups;
+        std::size_t depth = 0;
+        stitch(&root, depth, f);
+    }
 
-            if(closing_name != name){
-                throw std::runtime_error("Closing tag of " + name + " doesn't match!");
+    // Splits the input at '<' characters into one range per thread and parses the ranges concurrently.
+    // A split point can turn out to be inside a comment, a quoted value or CDATA. That shows once the range before it is
+    // known, because its last markup then ends past the split point, and the range is parsed again from where it really starts.
+    // The ranges are stitched in order with the same rules as the serial engine, so the tree is the same.
+    inline void document::parseParallel(){
+        details::thread_pool& workers = pool ? *pool : details::thread_pool::shared();
+        const std::size_t count = std::min(workers.size(), input.size() / minChunkSize);
+        if(count < 2){
+            parseDirect();
+            return;
+        }
+        std::vector<std::size_t> starts{0};
+        for(std::size_t k = 1; k < count; ++k){
+            const auto split = input.find('<', k * (input.size() / count));
+            if(split != std::string_view::npos && split > starts.back()){
+                starts.push_back(split);
             }
-            i += 3; // skip </name
+        }
+        starts.push_back(input.size());
 
-            if(i < tokens.size() && tokens[i].type == details::token_type::gt){
-                i++; // skip >
+        const std::size_t ranges = starts.size() - 1;
+        std::vector<fragment> parts(ranges);
+        std::vector<details::arena*> arenas{&memory};
+        for(std::size_t k = 1; k < ranges; ++k){
+            if(workerMemory.size() < k){
+                workerMemory.push_back(std::make_unique<details::arena>());
             }
+            arenas.push_back(workerMemory[k - 1].get());
         }
-        return element;
-    }
+        workers.parallelFor(ranges, [&](const std::size_t k){
+            try{
+                parseRange(parts[k], *arenas[k], starts[k], starts[k + 1]);
+            }catch(...){
+                parts[k].error = std::current_exception();// only an error if the range started where it was assumed to
+            }
+        });
 
-    inline void document::writeNode(const node& n, std::ostream& file, int depth) const {
-        const std::string ind(depth * 2, ' ');
-        switch (n.getType()){
-        case details::node_type::ELEMENT_NODE:{
-            file << ind << "<" << n.getValue();
-            
-            for(const auto& a : n.getAttributes()){
-                file << ' ' << a.first << "=\"";
-                if(!a.second.empty()){
-                    file << a.second << "\"";
-                }else{
-                    file << "\"";
-                }
+        node* current = &root;
+        std::size_t depth = 0;
+        std::size_t position = 0;
+        for(std::size_t k = 0; k < ranges; ++k){
+            if(starts[k] != position){
+                parts[k] = fragment();
+                arenas[k]->release();
+                parseRange(parts[k], *arenas[k], position, std::max(position, starts[k + 1]));
+            }else if(parts[k].error){
+                std::rethrow_exception(parts[k].error);
             }
+            statistics.tokens += parts[k].markups;
+            current = stitch(current, depth, parts[k]);
+            position = parts[k].end;
+        }
+    }
 
-            if(n.getChildren().empty()){
-                file << "/>\n";
-                return;    
+    // The first pass of parse_engine::lazy: one scan over the input that records where the content of every element starts
+    // and ends, checking nesting and closing tags on the way, and then only the top level of the document is built.
+    inline void document::parseLazy(){
+        details::lexer lex(input);
+        details::markup m;
+        std::vector<std::pair<std::size_t, std::string_view>> open;// span and name of the open elements
+        for(std::size_t before = 0; lex.next(m); before = lex.position()){
+            if(m.type == details::markup_type::start_tag || m.type == details::markup_type::empty_tag){
+                if(open.size() >= maxDepth){
+                    tooDeep();
+                }
+                if(m.type == details::markup_type::start_tag){
+                    spans.push_back({lex.position(), input.size()});
+                    open.push_back({spans.size() - 1, m.name});
+                }
+            }else if(m.type == details::markup_type::end_tag && !open.empty()){
+                if(m.name != open.back().second){
+                    throw std::runtime_error("Closing tag of " + std::string(open.back().second) + " doesn't match!");
+                }
+                spans[open.back().first].end = before;
+                open.pop_back();
             }
-            
-            file << ">\n";
+        }
+        expand(root, 0, input.size());
+    }
 
-            for(const auto& c : n.getChildren()){
-                writeNode(*c, file, depth + 1);
+    // Builds the children of n from the input in [from, until), the content of n. Child elements are jumped over with
+    // the spans of the first pass, only their attributes and the range of their content are recorded.
+    inline void document::expand(node& n, const std::size_t from, const std::size_t until){
+        details::lexer lex(input, from);
+        details::symbol_cache symbols(names);
+        details::markup m;
+        const bool top = n.type == details::node_type::DOCUMENT_NODE;
+        while(lex.position() < until && lex.next(m)){
+            switch (m.type){
+                case details::markup_type::start_tag:
+                case details::markup_type::empty_tag:{
+                    node* element = n.appendChild(makeElement(memory, symbols.intern(m.name)));
+                    if(!details::trimSpace(m.body).empty()){
+                        details::lazy_content& lazy = lazyPart(*element);
+                        lazy.attributes = m.body;
+                        lazy.attributesPending = true;
+                    }
+                    if(m.type == details::markup_type::start_tag){
+                        const auto span = *std::lower_bound(spans.begin(), spans.end(), lex.position(), [](const element_span& s, const std::size_t p){
+                            return s.start < p;
+                        });
+                        if(span.end != span.start){
+                            details::lazy_content& lazy = lazyPart(*element);
+                            lazy.children = input.substr(span.start, span.end - span.start);
+                            lazy.childrenPending = true;
+                        }
+                        lex.seek(span.end < until ? details::markupEnd(input, span.end) : span.end);// past the closing tag
+                    }
+                    break;
+                }
+                case details::markup_type::text:{
+                    const std::string_view text = decode(memory, collapse(memory, m.body));
+                    if(!text.empty() && !top){
+                        n.appendChild(makeNode(memory, details::node_type::TEXT_NODE, text));
+                    }
+                    break;
+                }
+                case details::markup_type::cdata:{
+                    if(!top){
+                        n.appendChild(makeNode(memory, details::node_type::TEXT_NODE, m.body));
+                    }
+                    break;
+                }
+                case details::markup_type::comment:{
+                    n.appendChild(makeNode(memory, details::node_type::COMMENT_NODE, collapse(memory, m.body)));
+                    break;
+                }
+                case details::markup_type::processing_instruction:{
+                    n.appendChild(makeNode(memory, details::node_type::PROCESSING_INSTRUCTION_NODE, memory.copy(details::normalizeInstruction(m.body))));
+                    break;
+                }
+                default:
+                    break;// stray closing tags of the top level and declarations such as <!DOCTYPE> aren't kept
             }
+        }
+    }
 
-            file << ind << "</" + n.getValue() + ">\n";
-            break;
+    inline details::lazy_content& document::lazyPart(node& n){
+        if(!n.pending){
+            n.pending = new (memory.allocate(sizeof(details::lazy_content), alignof(details::lazy_content))) details::lazy_content{this, {}, {}, false, false};
         }
-        case details::node_type::COMMENT_NODE:{
-            std::string comment = n.getValue();
-            if(!comment.empty()){
-                comment.pop_back();// it allways has a whitespace at the end, due to the parsing
-            }
-            file << ind << "<!--" << comment << "-->" << "\n";
-            break;
+        return *n.pending;
+    }
+
+    // Adds what a reader event describes below current and returns the node that is current afterwards.
+    // Event views don't outlive the reader's buffer, so every string is copied into the arena.
+    inline node* document::appendEvent(node* current, const details::event& e){
+        if constexpr (details::stats_enabled){
+            ++statistics.tokens;
         }
-        case details::node_type::TEXT_NODE:{
-            file << ind << n.getValue() << "\n";
-            break;
+        switch (e.type){
+            case details::event_type::start_element:
+                if(e.depth >= maxDepth){
+                    tooDeep();
+                }
+                return current->appendChild(makeElement(memory, names.intern(e.name)));
+            case details::event_type::attribute:
+                current->attributes.insert_or_assign(details::xml_string::borrow(names.intern(e.name).name), details::xml_string::borrow(memory.copy(e.value)));
+                break;
+            case details::event_type::end_element:
+                return current->parent;
+            case details::event_type::text:
+                current->appendChild(makeNode(memory, details::node_type::TEXT_NODE, memory.copy(e.value)));
+                break;
+            case details::event_type::comment:
+                current->appendChild(makeNode(memory, details::node_type::COMMENT_NODE, memory.copy(e.value)));
+                break;
+            case details::event_type::processing_instruction:
+                current->appendChild(makeNode(memory, details::node_type::PROCESSING_INSTRUCTION_NODE, memory.copy(e.value)));
+                break;
         }
-        case details::node_type::PROCESSING_INSTRUCTION_NODE:{
-            file << ind << "<?" << n.getValue() << "?>\n";
-            break;
+        return current;
+    }
+};
+
+namespace miniXML{
+    // A node of a lazily parsed document only lives in the document's arena, so it is never a const object.
+    inline void node::expandChildren() const {
+        node& self = const_cast<node&>(*this);
+        pending->childrenPending = false;
+        const document& owner = *pending->owner;
+        const auto from = static_cast<std::size_t>(pending->children.data() - owner.input.data());
+        try{
+            pending->owner->expand(self, from, from + pending->children.size());
+        }catch(...){
+            self.clearChildren();// a later access fails again instead of seeing part of the children
+            pending->childrenPending = true;
+            throw;
         }
-        default:
-            break;
+    }
+    inline void node::expandAttributes() const {
+        node& self = const_cast<node&>(*this);
+        pending->attributesPending = false;
+        details::symbol_table& names = pending->owner->names;
+        std::string_view span = pending->attributes, name, value;
+        const bool special = details::findFirstOf<details::tag_special_set>(span) != std::string_view::npos;
+        bool plain = !special;
+        try{
+            while(details::nextAttribute(span, name, value)){
+                plain = plain && details::fitsDoubleQuotes(value);
+                self.attributes.insert_or_assign(details::xml_string::borrow(names.intern(name).name),
+                    details::xml_string::borrow(special ? document::decode(pending->owner->memory, value) : value));
+            }
+            self.plainAttributes = plain;
+        }catch(...){
+            self.attributes.clear();
+            self.plainAttributes = false;
+            pending->attributesPending = true;
+            throw;
         }
     }
 };
\ No newline at end of file
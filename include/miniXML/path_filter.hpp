@@ -0,0 +1,124 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "document.hpp"
+#include "query.hpp"
+#include "reader.hpp"
+
+// Extracts the subtrees matching a set of path patterns from a stream, without building the rest of the document.
+namespace miniXML{
+    class path_filter{
+        public:
+            // Called with the root element of a matched subtree and the index of the pattern it matched.
+            // The subtree is freed when the callback returns.
+            using callback_type = std::function<void(node& record, std::size_t pattern)>;
+
+            path_filter() = default;
+            path_filter(const path_filter&) = delete;
+            path_filter& operator=(const path_filter&) = delete;
+
+            // Adds a pattern made of /name, //name and * steps, e.g. /feed/entry or //item. Patterns are always absolute.
+            // Returns the index passed to the callback for its matches.
+            std::size_t match(const std::string_view pattern, callback_type callback){
+                if(depth != 0 || inRecord){
+                    throw std::runtime_error("Patterns can't be added while a stream is being filtered");
+                }
+                const query compiled(pattern);
+                for(const auto& s : compiled.plan()){
+                    if(s.test == details::query_step::test_type::text || s.position || !s.before.empty() || !s.after.empty()){
+                        throw std::runtime_error("Invalid pattern " + std::string(pattern) + ": only element names and * are supported");
+                    }
+                }
+                if(!compiled.isAbsolute()){
+                    throw std::runtime_error("Invalid pattern " + std::string(pattern) + ": patterns have to start with /");
+                }
+                patterns.push_back({compiled.plan(), std::move(callback)});
+                return patterns.size() - 1;
+            }
+
+            // Reads events from in until it has no more and hands every matched subtree to its callback.
+            // A reader in push mode can be fed and passed again, a record can span several calls.
+            // Matches inside a record are part of that record and aren't reported on their own.
+            void run(reader& in){
+                details::event e;
+                in.skipContent(!inRecord);
+                while(in.next(e)){
+                    if(inRecord){
+                        current = record.appendEvent(current, e);
+                        if(e.type == details::event_type::end_element && e.depth == recordDepth){
+                            deliver();
+                            in.skipContent(true);
+                        }
+                    }else if(e.type == details::event_type::start_element){
+                        if(const auto matched = enter(e.name); matched != patterns.size()){
+                            record.reset();
+                            current = record.appendEvent(&record.root, e);
+                            inRecord = true;
+                            recordDepth = e.depth;
+                            recordPattern = matched;
+                            in.skipContent(false);// the attributes of this element come next
+                        }
+                    }else if(e.type == details::event_type::end_element){
+                        states.resize(states.size() - patterns.size());
+                        --depth;
+                    }
+                }
+            }
+        private:
+            struct pattern_entry{
+                std::vector<details::query_step> steps;
+                callback_type callback;
+            };
+
+            std::vector<pattern_entry> patterns;
+            std::vector<std::uint64_t> states;// per open element outside of a record and pattern, the steps it is a context of
+            std::size_t depth = 0;
+
+            document record;// holds the subtree being collected, emptied after every record
+            node* current = nullptr;
+            bool inRecord = false;
+            std::size_t recordDepth = 0;
+            std::size_t recordPattern = 0;
+
+            // Returns the first pattern the element that just started completes, or patterns.size() after pushing its states.
+            // This is the walk of query_iterator, run on events instead of the tree.
+            [[nodiscard]] std::size_t enter(const std::string_view name){
+                const std::size_t n = patterns.size();
+                const std::size_t parent = states.size();
+                states.resize(parent + n);
+                for(std::size_t p = 0; p < n; ++p){
+                    const auto& steps = patterns[p].steps;
+                    const std::uint64_t done = std::uint64_t(1) << steps.size();
+                    const std::uint64_t context = depth == 0 ? 1 : states[parent - n + p];
+                    std::uint64_t next = 0;
+                    for(std::size_t k = 0; k < steps.size(); ++k){
+                        if(!(context & (std::uint64_t(1) << k))){
+                            continue;
+                        }
+                        if(steps[k].descendant){
+                            next |= std::uint64_t(1) << k;
+                        }
+                        if(steps[k].test == details::query_step::test_type::any || steps[k].name == name){
+                            next |= std::uint64_t(1) << (k + 1);
+                        }
+                    }
+                    if(next & done){
+                        states.resize(parent);
+                        return p;
+                    }
+                    states[parent + p] = next;
+                }
+                ++depth;
+                return n;
+            }
+            void deliver(){
+                inRecord = false;
+                node& element = *record.root.getChildren().front();
+                patterns[recordPattern].callback(element, recordPattern);
+                record.reset();
+            }
+    };
+};
\ No newline at end of file
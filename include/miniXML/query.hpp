@@ -0,0 +1,333 @@
+#pragma once
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "node.hpp"
+#include "lexer.hpp"
+
+// Compiled path queries over the node tree.
+// Supported is a practical subset of XPath: /a/b, //item, *, text(), [@id], [@id='x'] and [n].
+namespace miniXML{
+    class query;
+
+    namespace details{
+        struct query_step{
+            enum class test_type{
+                name,
+                any,// *
+                text// text()
+            };
+            struct predicate{
+                std::string attribute;
+                std::string value;
+                bool hasValue = false;
+            };
+
+            bool descendant = false;// reached through //, otherwise a child of the context
+            test_type test = test_type::name;
+            std::string name;
+            std::vector<predicate> before;// attribute predicates written before [n], they decide what is counted
+            std::size_t position = 0;// 1 based, 0 when the step has no [n]
+            std::vector<predicate> after;
+        };
+
+        // Walks the tree once in document order and keeps, for every node on the way down, the set of steps whose context it is.
+        // A node is a result when the set of one of its children reaches past the last step, so every result is found once,
+        // in document order, and subtrees no step can continue in aren't entered.
+        template<class Node>
+        class query_iterator{
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = Node*;
+                using difference_type = std::ptrdiff_t;
+                using pointer = Node* const*;
+                using reference = Node* const&;
+
+                query_iterator() noexcept = default;
+                query_iterator(const std::vector<query_step>& s, Node* start) : steps(&s){
+                    for(const auto& step : s){
+                        counting = counting || step.position != 0;
+                    }
+                    stack.push_back({start, 0, 1});
+                    if(counting){
+                        counters.resize(steps->size(), 0);
+                    }
+                    advance();
+                }
+
+                reference operator*() const noexcept {
+                    return current;
+                }
+                query_iterator& operator++(){
+                    advance();
+                    return *this;
+                }
+                friend bool operator==(const query_iterator& a, const query_iterator& b) noexcept {
+                    return a.current == b.current;
+                }
+                friend bool operator!=(const query_iterator& a, const query_iterator& b) noexcept {
+                    return a.current != b.current;
+                }
+            private:
+                struct frame{
+                    Node* n;
+                    std::size_t child;
+                    std::uint64_t states;// bit k: n is a context of step k
+                };
+
+                const std::vector<query_step>* steps = nullptr;
+                std::vector<frame> stack;
+                std::vector<std::uint32_t> counters;// per frame and step, the children counted for [n]
+                bool counting = false;// only queries with [n] fill counters
+                Node* current = nullptr;
+
+                [[nodiscard]] static bool passes(const std::vector<query_step::predicate>& predicates, const node& n){
+                    for(const auto& p : predicates){
+                        const auto value = n.getAttribute(p.attribute);
+                        if(!value || (p.hasValue && *value != p.value)){
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+                [[nodiscard]] static bool matches(const query_step& s, const node& n){
+                    switch (s.test){
+                        case query_step::test_type::text:
+                            return n.getType() == node_type::TEXT_NODE;
+                        case query_step::test_type::any:
+                            return n.getType() == node_type::ELEMENT_NODE;
+                        default:
+                            return n.getType() == node_type::ELEMENT_NODE && n.getValue() == s.name;
+                    }
+                }
+
+                void advance(){
+                    const std::size_t count = steps->size();
+                    const std::uint64_t done = std::uint64_t(1) << count;
+                    while(!stack.empty()){
+                        frame& f = stack.back();
+                        if(f.child == f.n->getChildren().size()){
+                            stack.pop_back();
+                            if(counting){
+                                counters.resize(stack.size() * count);
+                            }
+                            continue;
+                        }
+                        Node* c = f.n->getChildren()[f.child++].get();
+                        std::uint32_t* counted = counting ? counters.data() + (stack.size() - 1) * count : nullptr;
+                        std::uint64_t next = 0;
+                        for(std::uint64_t pending = f.states; pending; pending &= pending - 1){
+                            const auto k = static_cast<std::size_t>(countTrailingZeros(pending));
+                            const query_step& s = (*steps)[k];
+                            if(s.descendant){
+                                next |= std::uint64_t(1) << k;// the context of // stays open below
+                            }
+                            if(!matches(s, *c) || !passes(s.before, *c)){
+                                continue;
+                            }
+                            if(s.position && ++counted[k] != s.position){
+                                continue;
+                            }
+                            if(passes(s.after, *c)){
+                                next |= std::uint64_t(1) << (k + 1);
+                            }
+                        }
+                        if((next & ~done) && !c->getChildren().empty()){
+                            stack.push_back({c, 0, next & ~done});
+                            if(counting){
+                                counters.resize(stack.size() * count, 0);
+                            }
+                        }
+                        if(next & done){
+                            current = c;
+                            return;
+                        }
+                    }
+                    current = nullptr;
+                }
+                [[nodiscard]] static unsigned countTrailingZeros(const std::uint64_t v) noexcept {
+                    unsigned n = 0;
+                    for(std::uint64_t bit = v; !(bit & 1); bit >>= 1){
+                        ++n;
+                    }
+                    return n;
+                }
+        };
+
+        template<class Node>
+        class query_range{
+            public:
+                using iterator = query_iterator<Node>;
+
+                query_range(const std::vector<query_step>& s, Node* start) : steps(s), from(start){}
+
+                [[nodiscard]] iterator begin() const {
+                    return iterator(steps, from);
+                }
+                [[nodiscard]] iterator end() const noexcept {
+                    return iterator();
+                }
+            private:
+                const std::vector<query_step>& steps;
+                Node* from;
+        };
+    }
+
+    class query{
+        public:
+            static constexpr std::size_t maxSteps = 63;
+
+            // Compiles path once, the query can then be evaluated any number of times, also from several threads.
+            // Paths starting with / are evaluated from the document node of the context, other paths from the context.
+            explicit query(const std::string_view path){
+                compile(path);
+            }
+
+            // Lazily yields the matching nodes in document order. The tree must not change while a range is iterated.
+            // The range refers to the query, so it can't be taken from a temporary one.
+            [[nodiscard]] details::query_range<node> select(node& context) const & {
+                return {steps, absolute ? top(&context) : &context};
+            }
+            [[nodiscard]] details::query_range<const node> select(const node& context) const & {
+                return {steps, absolute ? top(&context) : &context};
+            }
+            void select(node&) const && = delete;
+            void select(const node&) const && = delete;
+            [[nodiscard]] node* first(node& context) const {
+                return *select(context).begin();
+            }
+            [[nodiscard]] const node* first(const node& context) const {
+                return *select(context).begin();
+            }
+            [[nodiscard]] const std::vector<details::query_step>& plan() const noexcept {
+                return steps;
+            }
+            [[nodiscard]] bool isAbsolute() const noexcept {
+                return absolute;
+            }
+            [[nodiscard]] std::size_t count(const node& context) const {
+                std::size_t n = 0;
+                for(auto it = select(context).begin(); it != details::query_iterator<const node>(); ++it){
+                    ++n;
+                }
+                return n;
+            }
+        private:
+            std::vector<details::query_step> steps;
+            bool absolute = false;
+
+            template<class Node>
+            [[nodiscard]] static Node* top(Node* n) noexcept {
+                while(n->getParent()){
+                    n = n->getParent();
+                }
+                return n;
+            }
+
+            [[noreturn]] static void fail(const std::string_view path, const std::size_t at, const char* what){
+                throw std::runtime_error("Invalid query " + std::string(path) + " at " + std::to_string(at) + ": " + what);
+            }
+            [[nodiscard]] static bool isNameChar(const char c) noexcept {
+                return c != '/' && c != '[' && c != ']' && c != '@' && c != '=' && c != '\'' && c != '"' && !details::isSpace(c);
+            }
+
+            void compile(std::string_view path){
+                const std::string_view original = path;
+                std::size_t i = 0;
+                auto skipSpace = [&]{
+                    while(i < path.size() && details::isSpace(path[i])){
+                        ++i;
+                    }
+                };
+                auto readName = [&]{
+                    const std::size_t start = i;
+                    while(i < path.size() && isNameChar(path[i])){
+                        ++i;
+                    }
+                    if(i == start){
+                        fail(original, i, "expected a name");
+                    }
+                    return std::string(path.substr(start, i - start));
+                };
+
+                absolute = !path.empty() && path[0] == '/';
+                if(!absolute && path.size() > 1 && path[0] == '.' && path[1] == '/'){
+                    i = 1;// ./a and .//a are relative to the context
+                }
+                while(i < path.size() || steps.empty()){
+                    details::query_step s;
+                    if(i < path.size() && path[i] == '/'){
+                        ++i;
+                        if(i < path.size() && path[i] == '/'){
+                            s.descendant = true;
+                            ++i;
+                        }
+                    }else if(!steps.empty()){
+                        fail(original, i, "expected /");
+                    }
+                    if(path.compare(i, 6, "text()") == 0){
+                        s.test = details::query_step::test_type::text;
+                        i += 6;
+                    }else if(i < path.size() && path[i] == '*'){
+                        s.test = details::query_step::test_type::any;
+                        ++i;
+                    }else{
+                        s.name = readName();
+                    }
+                    while(i < path.size() && path[i] == '['){
+                        ++i;
+                        skipSpace();
+                        if(i < path.size() && path[i] == '@'){
+                            ++i;
+                            details::query_step::predicate p;
+                            p.attribute = readName();
+                            skipSpace();
+                            if(i < path.size() && path[i] == '='){
+                                ++i;
+                                skipSpace();
+                                if(i >= path.size() || (path[i] != '\'' && path[i] != '"')){
+                                    fail(original, i, "expected a quoted value");
+                                }
+                                const auto close = path.find(path[i], i + 1);
+                                if(close == std::string_view::npos){
+                                    fail(original, i, "unterminated value");
+                                }
+                                p.value = std::string(path.substr(i + 1, close - i - 1));
+                                p.hasValue = true;
+                                i = close + 1;
+                            }
+                            (s.position ? s.after : s.before).push_back(std::move(p));
+                        }else{
+                            std::size_t n = 0;
+                            const std::size_t start = i;
+                            while(i < path.size() && path[i] >= '0' && path[i] <= '9'){
+                                n = n * 10 + static_cast<std::size_t>(path[i++] - '0');
+                            }
+                            if(i == start || n == 0){
+                                fail(original, start, "expected @attribute or a position");
+                            }
+                            if(s.position){
+                                fail(original, start, "only one position per step is supported");
+                            }
+                            s.position = n;
+                        }
+                        skipSpace();
+                        if(i >= path.size() || path[i] != ']'){
+                            fail(original, i, "expected ]");
+                        }
+                        ++i;
+                    }
+                    steps.push_back(std::move(s));
+                    if(steps.size() > maxSteps){
+                        fail(original, i, "too many steps");
+                    }
+                    if(steps.back().test == details::query_step::test_type::text && i < path.size()){
+                        fail(original, i, "text() has to be the last step");
+                    }
+                }
+            }
+    };
+};
\ No newline at end of file
@@ -0,0 +1,290 @@
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+#include "lexer.hpp"
+
+#if defined(_WIN32)
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+// Streaming access to a document without building the tree.
+// The reader lexes with the same rules as the direct engine, so its events describe exactly the tree a document would hold.
+namespace miniXML{
+    class reader{
+        public:
+            // Called with a buffer to fill, returns the number of bytes written, 0 at the end of the input.
+            using source_type = std::function<std::size_t(char* buffer, std::size_t size)>;
+            static constexpr std::size_t defaultBufferSize = 64 * 1024;
+
+            // Pull mode, input is read from source whenever the buffered bytes don't hold a complete markup.
+            explicit reader(source_type s, std::size_t bufferSize = defaultBufferSize) : source(std::move(s)), buffer(bufferSize ? bufferSize : 1){}
+            explicit reader(std::istream& in, std::size_t bufferSize = defaultBufferSize)
+                : reader([&in](char* b, std::size_t n){
+                    in.read(b, static_cast<std::streamsize>(n));
+                    return static_cast<std::size_t>(in.gcount());
+                }, bufferSize){}
+            explicit reader(int fd, std::size_t bufferSize = defaultBufferSize)
+                : reader([fd](char* b, std::size_t n){
+#if defined(_WIN32)
+                    const auto r = ::_read(fd, b, static_cast<unsigned>(n));
+#else
+                    const auto r = ::read(fd, b, n);
+#endif
+                    if(r < 0){
+                        throw std::runtime_error("Failed to read from file descriptor");
+                    }
+                    return static_cast<std::size_t>(r);
+                }, bufferSize){}
+            // A document that is already in memory, it is lexed in place.
+            explicit reader(std::string_view xml) : whole(xml), ended(true){}
+            // Push mode, input is handed over with feed() and closed with finish().
+            reader() : buffer(defaultBufferSize){}
+
+            // Appends the next chunk of input. Chunks can end anywhere, even inside a tag or a comment.
+            void feed(const std::string_view chunk){
+                if(ended){
+                    throw std::runtime_error("Input was already finished");
+                }
+                if(filled + chunk.size() > buffer.size()){
+                    compact();
+                    if(filled + chunk.size() > buffer.size()){
+                        buffer.resize(std::max(buffer.size() * 2, filled + chunk.size()));
+                    }
+                }
+                std::memcpy(buffer.data() + filled, chunk.data(), chunk.size());
+                filled += chunk.size();
+            }
+            // Marks the end of the input, whatever is left buffered has to be complete.
+            void finish() noexcept {
+                ended = true;
+            }
+
+            // While on, next() only reports start_element and end_element, attributes, text, comments and PIs
+            // are passed over without being decoded. Can be switched at any event, e.g. to read the attributes of one element.
+            void skipContent(const bool on) noexcept {
+                contentSkipped = on;
+            }
+
+            // Bytes searched for the end of a markup and bytes moved to the front of the buffer so far. Markups that arrive
+            // in pieces are searched on from where the last search stopped, so both stay within the size of the input.
+            [[nodiscard]] std::size_t bytesSearched() const noexcept {
+                return searched;
+            }
+            [[nodiscard]] std::size_t bytesMoved() const noexcept {
+                return moved;
+            }
+
+            // Moves to the next event. Returns false at the end of the input, or in push mode when more input is needed.
+            [[nodiscard]] bool next(details::event& e){
+                if(contentSkipped){
+                    pendingAttributes = {};
+                }
+                std::string_view name, value;
+                if(!pendingAttributes.empty() && details::nextAttribute(pendingAttributes, name, value)){
+                    e = {details::event_type::attribute, name, pendingReferences ? decode(value) : value, pendingDepth};
+                    return true;
+                }
+                if(pendingEnd){
+                    pendingEnd = false;
+                    e = {details::event_type::end_element, pendingName, {}, pendingDepth};
+                    return true;
+                }
+
+                details::markup m;
+                while(nextMarkup(m)){
+                    switch (m.type){
+                        case details::markup_type::start_tag:
+                        case details::markup_type::empty_tag:{
+                            pendingName = m.name;
+                            pendingAttributes = m.body;
+                            pendingReferences = details::hasReferences(m.body);
+                            pendingDepth = open.size();
+                            if(m.type == details::markup_type::start_tag){
+                                open.push_back(openNames.size());
+                                openNames.append(m.name);
+                            }else{
+                                pendingEnd = true;
+                            }
+                            e = {details::event_type::start_element, m.name, {}, pendingDepth};
+                            return true;
+                        }
+                        case details::markup_type::end_tag:{
+                            if(open.empty()){
+                                break;// a stray closing tag, the document parsers skip it as well
+                            }
+                            const std::string_view expected = std::string_view(openNames).substr(open.back());
+                            if(m.name != expected){
+                                throw std::runtime_error("Closing tag of " + std::string(expected) + " doesn't match!");
+                            }
+                            openNames.resize(open.back());
+                            open.pop_back();
+                            e = {details::event_type::end_element, m.name, {}, open.size()};
+                            return true;
+                        }
+                        case details::markup_type::text:{
+                            if(open.empty() || contentSkipped){
+                                break;// text outside of the root element isn't part of the tree
+                            }
+                            const std::string_view text = decode(collapse(m.body));
+                            if(!text.empty()){
+                                e = {details::event_type::text, {}, text, open.size()};
+                                return true;
+                            }
+                            break;
+                        }
+                        case details::markup_type::cdata:{
+                            if(!open.empty() && !contentSkipped){
+                                e = {details::event_type::text, {}, m.body, open.size()};
+                                return true;
+                            }
+                            break;
+                        }
+                        case details::markup_type::comment:{
+                            if(contentSkipped){
+                                break;
+                            }
+                            e = {details::event_type::comment, {}, collapse(m.body), open.size()};
+                            return true;
+                        }
+                        case details::markup_type::processing_instruction:{
+                            if(contentSkipped){
+                                break;
+                            }
+                            scratch = details::normalizeInstruction(m.body);
+                            e = {details::event_type::processing_instruction, m.name, scratch, open.size()};
+                            return true;
+                        }
+                        default:
+                            break;
+                    }
+                }
+                return false;
+            }
+            // Calls handler(const details::event&) for every remaining event.
+            template<class Handler>
+            void parse(Handler&& handler){
+                details::event e;
+                while(next(e)){
+                    handler(e);
+                }
+            }
+
+            // True once the whole input has been consumed.
+            [[nodiscard]] bool done() const noexcept {
+                return ended && available().empty() && pendingAttributes.empty() && !pendingEnd;
+            }
+            [[nodiscard]] std::size_t depth() const noexcept {
+                return open.size();
+            }
+            // Bytes currently held by the reader, the memory it uses is bounded by the largest single markup.
+            [[nodiscard]] std::size_t bufferCapacity() const noexcept {
+                return buffer.size();
+            }
+        private:
+            source_type source;
+            std::vector<char> buffer;
+            std::size_t begin = 0;
+            std::size_t filled = 0;
+            std::string_view whole;
+            bool ended = false;
+
+            std::string openNames;// names of the open elements, back to back
+            std::vector<std::size_t> open;// where each open name starts in openNames
+            std::string scratch;
+            std::string_view pendingName;
+            std::string_view pendingAttributes;
+            bool pendingReferences = false;// pendingAttributes contains a '&'
+            std::size_t pendingDepth = 0;
+            bool pendingEnd = false;
+            bool contentSkipped = false;
+            details::markup_scan scan;// how far the markup at the start of available() was searched
+            std::size_t searched = 0;
+            std::size_t moved = 0;
+
+            [[nodiscard]] std::string_view available() const noexcept {
+                if(!whole.empty() || buffer.empty()){
+                    return whole.substr(std::min(begin, whole.size()));
+                }
+                return std::string_view(buffer.data() + begin, filled - begin);
+            }
+            void compact() noexcept {
+                if(begin != 0 && whole.empty()){
+                    std::memmove(buffer.data(), buffer.data() + begin, filled - begin);
+                    moved += filled - begin;
+                    filled -= begin;
+                    begin = 0;
+                }
+            }
+            // Pulls more bytes from the source, returns false if there is nothing more to get right now.
+            [[nodiscard]] bool refill(){
+                if(ended || !source){
+                    return false;
+                }
+                // moving the unread bytes to the front only once half the buffer is used up keeps it linear
+                if(buffer.size() - filled < buffer.size() / 2){
+                    compact();
+                }
+                if(filled == buffer.size()){
+                    buffer.resize(buffer.size() * 2);// a single markup is larger than the buffer
+                }
+                const std::size_t n = source(buffer.data() + filled, buffer.size() - filled);
+                if(n == 0){
+                    ended = true;
+                }
+                filled += n;
+                return true;
+            }
+            [[nodiscard]] bool nextMarkup(details::markup& m){
+                while(true){
+                    const std::string_view in = available();
+                    if(!in.empty()){
+                        const std::size_t from = scan.from;
+                        std::size_t end = details::markupEnd(in, 0, scan);
+                        searched += (end == std::string_view::npos ? in.size() : end) - from;
+                        if(end == std::string_view::npos && ended){
+                            scan = {};
+                            if(in[0] == '<'){
+                                throw std::runtime_error("Unexpected end of input");
+                            }
+                            end = in.size();// trailing text
+                        }
+                        if(end != std::string_view::npos){
+                            m = details::classifyMarkup(in, 0, end);
+                            begin += end;
+                            return true;
+                        }
+                    }else if(ended){
+                        return false;
+                    }
+                    if(!refill()){
+                        return false;
+                    }
+                }
+            }
+            [[nodiscard]] std::string_view collapse(const std::string_view raw){
+                const std::string_view trimmed = details::trimSpace(raw);
+                if(details::isCollapsed(trimmed)){
+                    return trimmed;
+                }
+                scratch = details::collapseWhitespace(trimmed);
+                return scratch;
+            }
+            // Returns v with its entities decoded, in scratch when it has any.
+            [[nodiscard]] std::string_view decode(const std::string_view v){
+                if(!details::hasReferences(v)){
+                    return v;
+                }
+                if(v.data() != scratch.data()){
+                    scratch.assign(v);
+                }
+                scratch.resize(details::decodeEntities(scratch, scratch.data()));
+                return scratch;
+            }
+    };
+};
\ No newline at end of file
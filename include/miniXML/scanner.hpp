@@ -0,0 +1,234 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(_M_X64) || ((defined(__i386__) || defined(_M_IX86)) && defined(__SSE2__))
+    #define MINIXML_SCANNER_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define MINIXML_TARGET_AVX2
+    #else
+        #define MINIXML_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+// Vectorized search kernels used by the tokenizer and the lexer to find the next interesting byte.
+// AVX2 and SSE2 versions are picked at runtime, other targets (or MINIXML_NO_SIMD) use the scalar loop.
+namespace miniXML::details{
+    // Up to 8 bytes to look for, optionally together with the XML whitespace characters.
+    struct byte_set{
+        char chars[8];
+        std::size_t count;
+        bool whitespace;
+        std::array<bool, 256> table;
+
+        constexpr byte_set(const std::string_view needles, const bool space) : chars{}, count(needles.size()), whitespace(space), table{} {
+            for(std::size_t i = 0; i < needles.size() && i < 8; ++i){
+                chars[i] = needles[i];
+                table[static_cast<unsigned char>(needles[i])] = true;
+            }
+            if(space){
+                for(const char c : {' ', '\t', '\n', '\v', '\f', '\r'}){
+                    table[static_cast<unsigned char>(c)] = true;
+                }
+            }
+        }
+        [[nodiscard]] constexpr bool contains(const char c) const noexcept {
+            return table[static_cast<unsigned char>(c)];
+        }
+    };
+
+    inline constexpr byte_set whitespace_set("", true);
+    // whitespace other than ' ', which never survives whitespace collapsing
+    inline constexpr byte_set line_space_set("\t\n\v\f\r", false);
+    // the characters that end an identifier in document::tokenize()
+    inline constexpr byte_set identifier_end_set("<>=/?-", true);
+    // the end of a tag, or the start of a quoted value inside it
+    inline constexpr byte_set tag_delimiter_set(">\"'", false);
+    inline constexpr byte_set attribute_name_end_set("=", true);
+    // the start of an entity or character reference
+    inline constexpr byte_set reference_set("&", false);
+    // the characters escaped when text and attribute values are written
+    inline constexpr byte_set text_escape_set("&<>", false);
+    inline constexpr byte_set attribute_escape_set("&<>\"", false);
+    // The attribute values of a tag without any of these have no references and, but for '"', nothing to escape.
+    inline constexpr byte_set tag_special_set("&<>", false);
+
+    enum class simd_level{
+        scalar,
+        sse2,
+        avx2
+    };
+
+    [[nodiscard]] inline simd_level detectSimdLevel() noexcept {
+#if defined(MINIXML_SCANNER_X86) && !defined(MINIXML_NO_SIMD)
+    #if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if(info[0] >= 7){
+            __cpuid(info, 1);
+            const bool osxsave = (info[2] & (1 << 27)) != 0;
+            __cpuidex(info, 7, 0);
+            if(osxsave && (info[1] & (1 << 5)) != 0 && (_xgetbv(0) & 6) == 6){
+                return simd_level::avx2;
+            }
+        }
+    #else
+        if(__builtin_cpu_supports("avx2")){
+            return simd_level::avx2;
+        }
+    #endif
+        return simd_level::sse2;
+#else
+        return simd_level::scalar;
+#endif
+    }
+
+    // The level used by the kernels, detected once. Can be lowered, e.g. to compare the kernels against each other.
+    [[nodiscard]] inline simd_level& simdLevel() noexcept {
+        static simd_level level = detectSimdLevel();
+        return level;
+    }
+
+    template<const byte_set& Set, bool Negate>
+    [[nodiscard]] inline std::size_t scanScalar(const char* p, std::size_t i, const std::size_t n) noexcept {
+        while(i < n && Set.contains(p[i]) == Negate){
+            ++i;
+        }
+        return i;
+    }
+
+#if defined(MINIXML_SCANNER_X86)
+    [[nodiscard]] inline unsigned countTrailingZeros(const std::uint64_t v) noexcept {
+    #if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanForward64(&index, v);
+        return static_cast<unsigned>(index);
+    #else
+        return static_cast<unsigned>(__builtin_ctzll(v));
+    #endif
+    }
+
+    template<const byte_set& Set>
+    [[nodiscard]] inline __m128i matchSse2(const __m128i x) noexcept {
+        __m128i m = _mm_setzero_si128();
+        for(std::size_t k = 0; k < Set.count; ++k){
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8(Set.chars[k])));
+        }
+        if constexpr (Set.whitespace){
+            // ' ' or one of \t \n \v \f \r, which are 9 to 13
+            const __m128i shifted = _mm_sub_epi8(x, _mm_set1_epi8(9));
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+            m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted));
+        }
+        return m;
+    }
+
+    // Bit k is set when byte p[k] is a match.
+    template<const byte_set& Set, bool Negate>
+    [[nodiscard]] inline unsigned blockSse2(const char* p) noexcept {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(matchSse2<Set>(x)));
+        return Negate ? ~mask & 0xFFFFu : mask;
+    }
+
+    template<const byte_set& Set, bool Negate>
+    [[nodiscard]] inline std::size_t scanSse2(const char* p, std::size_t i, const std::size_t n) noexcept {
+        for(; i + 16 <= n; i += 16){
+            if(const unsigned mask = blockSse2<Set, Negate>(p + i)){
+                return i + countTrailingZeros(mask);
+            }
+        }
+        return scanScalar<Set, Negate>(p, i, n);
+    }
+
+    template<const byte_set& Set>
+    [[nodiscard]] MINIXML_TARGET_AVX2 inline __m256i matchAvx2(const __m256i x) noexcept {
+        __m256i m = _mm256_setzero_si256();
+        for(std::size_t k = 0; k < Set.count; ++k){
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(Set.chars[k])));
+        }
+        if constexpr (Set.whitespace){
+            const __m256i shifted = _mm256_sub_epi8(x, _mm256_set1_epi8(9));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted));
+        }
+        return m;
+    }
+
+    // 64 bytes per iteration, then 32, then the SSE2 kernel finishes the tail.
+    template<const byte_set& Set, bool Negate>
+    [[nodiscard]] MINIXML_TARGET_AVX2 inline std::size_t scanAvx2(const char* p, std::size_t i, const std::size_t n) noexcept {
+        for(; i + 64 <= n; i += 64){
+            const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+            const __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 32));
+            std::uint64_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(matchAvx2<Set>(lo)))
+                | static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(matchAvx2<Set>(hi)))) << 32;
+            if constexpr (Negate){
+                mask = ~mask;
+            }
+            if(mask){
+                return i + countTrailingZeros(mask);
+            }
+        }
+        if(i + 32 <= n){
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+            std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(matchAvx2<Set>(x)));
+            if constexpr (Negate){
+                mask = ~mask;
+            }
+            if(mask){
+                return i + countTrailingZeros(mask);
+            }
+            i += 32;
+        }
+        return scanSse2<Set, Negate>(p, i, n);
+    }
+#endif
+
+    template<const byte_set& Set, bool Negate>
+    [[nodiscard]] inline std::size_t scan(const std::string_view s, const std::size_t from) noexcept {
+        if(from >= s.size()){
+            return std::string_view::npos;
+        }
+        std::size_t i = from;
+        const simd_level level = simdLevel();
+        switch (level){
+#if defined(MINIXML_SCANNER_X86)
+            case simd_level::avx2:
+            case simd_level::sse2:{
+                // most runs are short, so the first 32 bytes are probed inline before calling a wide kernel
+                for(int block = 0; block < 2 && i + 16 <= s.size(); ++block, i += 16){
+                    if(const unsigned mask = blockSse2<Set, Negate>(s.data() + i)){
+                        return i + countTrailingZeros(mask);
+                    }
+                }
+                if(level == simd_level::avx2 && i + 64 <= s.size()){
+                    i = scanAvx2<Set, Negate>(s.data(), i, s.size());
+                }else{
+                    i = scanSse2<Set, Negate>(s.data(), i, s.size());
+                }
+                break;
+            }
+#endif
+            default:
+                i = scanScalar<Set, Negate>(s.data(), from, s.size());
+                break;
+        }
+        return i < s.size() ? i : std::string_view::npos;
+    }
+
+    // Position of the first byte at or after from that is in Set, or npos.
+    template<const byte_set& Set>
+    [[nodiscard]] inline std::size_t findFirstOf(const std::string_view s, const std::size_t from = 0) noexcept {
+        return scan<Set, false>(s, from);
+    }
+    // Position of the first byte at or after from that isn't in Set, or npos.
+    template<const byte_set& Set>
+    [[nodiscard]] inline std::size_t findFirstNotOf(const std::string_view s, const std::size_t from = 0) noexcept {
+        return scan<Set, true>(s, from);
+    }
+};
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include "types.hpp"
+
+// Parse and serialize counters of a document, see document::stats().
+// They are only collected when MINIXML_STATS is defined to a non zero value (CMake option MINIXML_STATS),
+// otherwise every hook compiles away and stats() stays zero.
+#ifndef MINIXML_STATS
+    #define MINIXML_STATS 0
+#endif
+
+namespace miniXML::details{
+    inline constexpr bool stats_enabled = MINIXML_STATS != 0;
+
+    struct document_stats{
+        std::size_t bytesScanned = 0;
+        std::size_t tokens = 0;// tokens of the token engine, markups lexed by the other engines, events added by incremental_parser
+        std::array<std::size_t, 6> nodes{};// by node_type
+        std::size_t attributes = 0;
+        std::size_t maxDepth = 0;// of the deepest node below the document node
+        std::size_t arenaBlocks = 0;// blocks reserved by the arenas of the document
+        std::size_t arenaBytes = 0;
+        std::size_t heapNodes = 0;// nodes allocated one by one on the heap, by the token engine or through the API
+        // Heap allocations of the parse: arena blocks, and the nodes, strings, child lists and attribute lists allocated
+        // one by one. The copy of the input, the token vector of the token engine and the index of the symbol table aren't included.
+        std::size_t allocations = 0;
+        std::size_t bytesAllocated = 0;
+        double tokenizeSeconds = 0;
+        double buildSeconds = 0;// building the tree, for the direct engines this includes lexing
+        double writeSeconds = 0;// in writeToFile() and document::toString()
+        std::size_t bytesWritten = 0;
+
+        [[nodiscard]] std::size_t nodeCount(const node_type t) const noexcept {
+            return nodes[static_cast<std::size_t>(t)];
+        }
+    };
+
+    // Heap allocations made one by one on the tree's behalf, see countAllocation(). Arenas count their blocks themselves.
+    struct allocation_count{
+        std::size_t allocations = 0;
+        std::size_t bytes = 0;
+    };
+    // Per thread, so counting doesn't synchronize. Parsing allocates nodes one by one only on the thread that parses.
+    inline thread_local allocation_count heapAllocations;
+
+    // Counts an allocation in heapAllocations, does nothing when stats are disabled.
+    inline void countAllocation(const std::size_t bytes) noexcept {
+        if constexpr (stats_enabled){
+            ++heapAllocations.allocations;
+            heapAllocations.bytes += bytes;
+        }
+    }
+
+    // Adds the time until it goes out of scope to target, does nothing when stats are disabled.
+    class phase_timer{
+        public:
+            explicit phase_timer(double& t) noexcept : target(t){
+                if constexpr (stats_enabled){
+                    start = std::chrono::steady_clock::now();
+                }
+            }
+            phase_timer(const phase_timer&) = delete;
+            phase_timer& operator=(const phase_timer&) = delete;
+            ~phase_timer(){
+                if constexpr (stats_enabled){
+                    target += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                }
+            }
+        private:
+            double& target;
+            std::chrono::steady_clock::time_point start{};
+    };
+};
\ No newline at end of file
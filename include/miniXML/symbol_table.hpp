@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "arena.hpp"
+
+// Per document table of element and attribute names.
+// Every distinct name is stored once, parsed elements and attribute keys point at the stored copy and elements keep its id.
+namespace miniXML::details{
+    using symbol_id = std::uint32_t;
+    // Id of values that aren't in the table, e.g. of nodes created through the public API.
+    inline constexpr symbol_id no_symbol = 0;
+
+    struct symbol{
+        symbol_id id = no_symbol;
+        std::string_view name;
+    };
+
+    class symbol_table{
+        public:
+            symbol_table() = default;
+            symbol_table(const symbol_table&) = delete;
+            symbol_table& operator=(const symbol_table&) = delete;
+
+            // The symbol of n, which is added when it is new. Can be called from several threads at once.
+            [[nodiscard]] symbol intern(const std::string_view n){
+                {
+                    std::shared_lock<std::shared_mutex> lock(guard);
+                    const auto it = ids.find(n);
+                    if(it != ids.end()){
+                        return {it->second, it->first};
+                    }
+                }
+                std::unique_lock<std::shared_mutex> lock(guard);
+                const auto it = ids.find(n);// another thread may have added it in between
+                if(it != ids.end()){
+                    return {it->second, it->first};
+                }
+                const std::string_view stored = storage.copy(n);
+                names.push_back(stored);
+                const auto id = static_cast<symbol_id>(names.size());
+                ids.emplace(stored, id);
+                return {id, stored};
+            }
+            // The symbol of n, with no_symbol as id if the table doesn't hold it.
+            [[nodiscard]] symbol find(const std::string_view n) const {
+                std::shared_lock<std::shared_mutex> lock(guard);
+                const auto it = ids.find(n);
+                return it != ids.end() ? symbol{it->second, it->first} : symbol{no_symbol, n};
+            }
+            [[nodiscard]] std::string_view name(const symbol_id id) const {
+                std::shared_lock<std::shared_mutex> lock(guard);
+                return id != no_symbol && id <= names.size() ? names[id - 1] : std::string_view();
+            }
+            [[nodiscard]] std::size_t size() const {
+                std::shared_lock<std::shared_mutex> lock(guard);
+                return names.size();
+            }
+            [[nodiscard]] std::size_t blockCount() const {
+                std::shared_lock<std::shared_mutex> lock(guard);
+                return storage.blockCount();
+            }
+            [[nodiscard]] allocation_count heapAllocations() const {
+                std::shared_lock<std::shared_mutex> lock(guard);
+                return storage.heapAllocations();
+            }
+            [[nodiscard]] std::size_t bytesReserved() const {
+                std::shared_lock<std::shared_mutex> lock(guard);
+                return storage.bytesReserved();
+            }
+            void clear(){
+                std::unique_lock<std::shared_mutex> lock(guard);
+                ids.clear();
+                names.clear();
+                storage.release();
+            }
+        private:
+            mutable std::shared_mutex guard;
+            arena storage;
+            std::unordered_map<std::string_view, symbol_id> ids;
+            std::vector<std::string_view> names;// by id - 1
+    };
+
+    // Direct mapped cache in front of a symbol_table, one per parsing thread.
+    // Names repeat a lot, so most of them are found here without hashing or taking the table's lock.
+    class symbol_cache{
+        public:
+            explicit symbol_cache(symbol_table& t) noexcept : table(t){}
+
+            [[nodiscard]] symbol intern(const std::string_view n){
+                if(n.empty()){
+                    return {};
+                }
+                symbol& slot = slots[slotOf(n)];
+                if(slot.name != n){
+                    slot = table.intern(n);
+                }
+                return slot;
+            }
+        private:
+            static constexpr std::size_t slotCount = 256;
+
+            symbol_table& table;
+            symbol slots[slotCount]{};
+
+            [[nodiscard]] static std::size_t slotOf(const std::string_view n) noexcept {
+                return (n.size() * 31 + static_cast<unsigned char>(n.front()) * 7 + static_cast<unsigned char>(n.back())) % slotCount;
+            }
+    };
+};
\ No newline at end of file
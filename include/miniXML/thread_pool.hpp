@@ -0,0 +1,145 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Small fixed size pool used by the parallel parts of the library.
+namespace miniXML::details{
+    class thread_pool{
+        public:
+            // threads is the total concurrency, the thread calling parallelFor() counts as one of them.
+            explicit thread_pool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())){
+                for(std::size_t i = 1; i < threads; ++i){
+                    workers.emplace_back([this, i]{ work(i); });
+                }
+            }
+            thread_pool(const thread_pool&) = delete;
+            thread_pool& operator=(const thread_pool&) = delete;
+            ~thread_pool(){
+                {
+                    std::lock_guard<std::mutex> lock(state);
+                    stopping = true;
+                }
+                wake.notify_all();
+                for(auto& w : workers){
+                    w.join();
+                }
+            }
+
+            [[nodiscard]] std::size_t size() const noexcept {
+                return workers.size() + 1;
+            }
+
+            // Calls fn(i) for every i < count, spread over the pool and the calling thread, and returns when all calls are done.
+            // Indices are handed out one at a time, so uneven items balance out. The first exception thrown by fn is rethrown here.
+            // fn is called as fn(i) or as fn(i, worker), where worker is below size() and stays the same for all calls on
+            // one thread, e.g. to index scratch state kept per thread. A parallelFor() on the same pool from inside fn runs
+            // serially on the thread calling it, as the pool is already busy with the outer one.
+            template<class F>
+            void parallelFor(const std::size_t count, F&& fn){
+                auto call = [&fn](const std::size_t i, const std::size_t worker){
+                    if constexpr (std::is_invocable_v<F&, std::size_t, std::size_t>){
+                        fn(i, worker);
+                    }else{
+                        fn(i);
+                    }
+                };
+                if(count == 0){
+                    return;
+                }
+                if(workers.empty() || count == 1 || runningHere()){
+                    for(std::size_t i = 0; i < count; ++i){
+                        call(i, 0);
+                    }
+                    return;
+                }
+                std::lock_guard<std::mutex> exclusive(running);
+                std::atomic<std::size_t> nextIndex{0};
+                std::exception_ptr error;
+                std::mutex errorLock;
+                auto body = [&](const std::size_t worker){
+                    const thread_pool* outer = std::exchange(active, this);
+                    for(std::size_t i; (i = nextIndex.fetch_add(1)) < count;){
+                        try{
+                            call(i, worker);
+                        }catch(...){
+                            std::lock_guard<std::mutex> lock(errorLock);
+                            if(!error){
+                                error = std::current_exception();
+                            }
+                        }
+                    }
+                    active = outer;
+                };
+                {
+                    std::lock_guard<std::mutex> lock(state);
+                    task = body;
+                    pending = workers.size();
+                    ++generation;
+                }
+                wake.notify_all();
+                body(0);
+                {
+                    std::unique_lock<std::mutex> lock(state);
+                    finished.wait(lock, [this]{ return pending == 0; });
+                    task = nullptr;
+                }
+                if(error){
+                    std::rethrow_exception(error);
+                }
+            }
+
+            // Whether the calling thread is running a parallelFor() of this pool.
+            [[nodiscard]] bool runningHere() const noexcept {
+                return active == this;
+            }
+
+            // Process wide pool with one thread per hardware thread.
+            [[nodiscard]] static thread_pool& shared(){
+                static thread_pool pool;
+                return pool;
+            }
+        private:
+            std::vector<std::thread> workers;
+            std::mutex running;// one parallelFor() at a time
+            std::mutex state;
+            std::condition_variable wake;
+            std::condition_variable finished;
+            std::function<void(std::size_t)> task;
+            std::size_t generation = 0;
+            std::size_t pending = 0;
+            bool stopping = false;
+            static inline thread_local const thread_pool* active = nullptr;// the pool whose parallelFor() this thread runs
+
+            void work(const std::size_t worker){
+                std::size_t seen = 0;
+                while(true){
+                    std::function<void(std::size_t)> job;
+                    {
+                        std::unique_lock<std::mutex> lock(state);
+                        wake.wait(lock, [&]{ return stopping || generation != seen; });
+                        if(stopping){
+                            return;
+                        }
+                        seen = generation;
+                        job = task;
+                    }
+                    job(worker);
+                    {
+                        std::lock_guard<std::mutex> lock(state);
+                        if(--pending == 0){
+                            finished.notify_one();
+                        }
+                    }
+                }
+            }
+    };
+};
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 // Primitive internal types used across the library
 // Uses a special namespace to avoid namespace pollution
 namespace miniXML::details{
@@ -18,9 +19,52 @@ namespace miniXML::details{
         COMMENT_NODE,
         PROCESSING_INSTRUCTION_NODE
     };
+    // Selects how a document turns its content into a tree.
+    // tokens: tokenize() into a token vector, then buildTree() walks it.
+    // direct: a single forward scan over the content that builds nodes as it goes.
+    // parallel: the direct engine run on several ranges of the content at once, see document::setThreadPool().
+    // lazy: one skip scan records where the content of every element is, at any depth, and builds only the top level.
+    // The children and attributes of a node are parsed the first time they are accessed.
+    enum class parse_engine{
+        tokens,
+        direct,
+        parallel,
+        lazy
+    };
+    // Selects how the file constructor gets the bytes of a file.
+    // read: one read into the document's own buffer.
+    // map: the file is memory mapped and parsed in place, the mapping backs the node strings.
+    // map_populate: like map, but the whole file is faulted in before parsing starts.
+    enum class load_mode{
+        read,
+        map,
+        map_populate
+    };
+    // indented puts every node on its own line, indented by two spaces per level. compact writes no whitespace at all.
+    enum class output_format{
+        indented,
+        compact
+    };
 
     struct token{
         token_type type;
         std::string value;
     };
+
+    enum class event_type{
+        start_element,
+        attribute,
+        text,
+        comment,
+        processing_instruction,
+        end_element
+    };
+    // An event of miniXML::reader. name is the element or attribute name, value the attribute value, text, comment or PI content.
+    // Both views are only valid until the next call to reader::next().
+    struct event{
+        event_type type;
+        std::string_view name;
+        std::string_view value;
+        std::size_t depth;// number of open elements around the item, the root element is at 0
+    };
 };
\ No newline at end of file
@@ -0,0 +1,413 @@
+#pragma once
+#include <algorithm>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "node.hpp"
+#include "scanner.hpp"
+#include "thread_pool.hpp"
+
+// The serialization engine behind node::toString() and document::writeToFile().
+// Output goes to one growable buffer, which is either returned as a string or flushed to a stream in large blocks.
+// parallel_writer runs it on a thread pool for large documents.
+namespace miniXML::details{
+    class output_buffer{
+        public:
+            static constexpr std::size_t blockSize = std::size_t(1) << 20;
+
+            // Collects the whole output, see str().
+            output_buffer() = default;
+            // Writes to sink every time a block is full, call flush() at the end.
+            explicit output_buffer(std::ostream& s) : sink(&s){
+                data.reserve(blockSize + blockSize / 4);
+            }
+
+            void append(const std::string_view s){
+                data.append(s);
+                if(sink && data.size() >= blockSize){
+                    flush();
+                }
+            }
+            void put(const char c){
+                data.push_back(c);
+            }
+            void flush(){
+                if(sink && !data.empty()){
+                    sink->write(data.data(), static_cast<std::streamsize>(data.size()));
+                    flushed += data.size();
+                    data.clear();
+                }
+            }
+            // Bytes appended so far, flushed or not.
+            [[nodiscard]] std::size_t written() const noexcept {
+                return flushed + data.size();
+            }
+            [[nodiscard]] std::string& str() noexcept {
+                return data;
+            }
+        private:
+            std::string data;
+            std::ostream* sink = nullptr;
+            std::size_t flushed = 0;
+    };
+
+    // Counts the bytes a serializer writes without keeping them.
+    class output_counter{
+        public:
+            void append(const std::string_view s) noexcept {
+                count += s.size();
+            }
+            void put(const char) noexcept {
+                ++count;
+            }
+            [[nodiscard]] std::size_t written() const noexcept {
+                return count;
+            }
+        private:
+            std::size_t count = 0;
+    };
+
+    // Writes into memory that an output_counter pass sized, so it doesn't check for room.
+    class output_slice{
+        public:
+            explicit output_slice(char* at) noexcept : position(at){}
+
+            void append(const std::string_view s) noexcept {
+                position = std::copy(s.begin(), s.end(), position);
+            }
+            void put(const char c) noexcept {
+                *position++ = c;
+            }
+        private:
+            char* position;
+    };
+
+    // A part of a tree written by parallel_writer: the start or end tag of n, or the children [first, last) of n with
+    // their subtrees. depth is the one of n.
+    struct write_piece{
+        enum class part{
+            start,
+            children,
+            end
+        };
+        part what;
+        const node* n;
+        std::size_t first;
+        std::size_t last;
+        std::size_t depth;
+        std::size_t size = 0;// bytes of output, set by the counting pass
+    };
+
+    template<class Output>
+    class basic_serializer{
+        public:
+            basic_serializer(Output& o, const output_format f) : out(o), indented(f == output_format::indented){}
+
+            // Writes n and its subtree. Elements with children are kept on an explicit stack until their closing tag,
+            // so any depth of nesting can be written.
+            void write(const node& n, const std::size_t depth){
+                open(n, depth);
+                while(!pending.empty()){
+                    frame& f = pending.back();
+                    if(f.next == f.n->getChildren().size()){
+                        close(f);
+                        pending.pop_back();
+                        continue;
+                    }
+                    const node& c = *f.n->getChildren()[f.next++];
+                    open(c, f.n->getType() == node_type::ELEMENT_NODE ? f.depth + 1 : f.depth);
+                }
+            }
+            // Writes one piece, the pieces of a tree written one after the other give the output of write().
+            void write(const write_piece& p){
+                switch (p.what){
+                    case write_piece::part::start:
+                        open(*p.n, p.depth);
+                        pending.clear();
+                        break;
+                    case write_piece::part::children:{
+                        const auto& children = p.n->getChildren();
+                        const std::size_t depth = p.n->getType() == node_type::ELEMENT_NODE ? p.depth + 1 : p.depth;
+                        for(std::size_t i = p.first; i < p.last; ++i){
+                            write(*children[i], depth);
+                        }
+                        break;
+                    }
+                    case write_piece::part::end:
+                        close({p.n, 0, p.depth});
+                        break;
+                }
+            }
+        private:
+            Output& out;
+            bool indented;
+            std::string spaces;// the indentation of the deepest level seen so far, sliced for every line
+
+            struct frame{
+                const node* n;
+                std::size_t next;// the child written next
+                std::size_t depth;
+            };
+            std::vector<frame> pending;// nodes whose children are being written, innermost last
+
+            // Writes n, or only its start when it has children, which then come before close().
+            void open(const node& n, const std::size_t depth){
+                switch (n.getType()){
+                    case node_type::ELEMENT_NODE:{
+                        indent(depth);
+                        out.put('<');
+                        out.append(n.getValue());
+                        for(const auto& a : n.getAttributes()){
+                            out.put(' ');
+                            out.append(a.first);
+                            out.append("=\"");
+                            if(n.plainAttributes){
+                                out.append(a.second);
+                            }else{
+                                escaped<attribute_escape_set>(a.second);
+                            }
+                            out.put('"');
+                        }
+                        if(n.getChildren().empty()){
+                            out.append("/>");
+                            newline();
+                            break;
+                        }
+                        out.put('>');
+                        newline();
+                        pending.push_back({&n, 0, depth});
+                        break;
+                    }
+                    case node_type::TEXT_NODE:{
+                        indent(depth);
+                        escaped<text_escape_set>(n.getValue());
+                        newline();
+                        break;
+                    }
+                    case node_type::COMMENT_NODE:{
+                        indent(depth);
+                        out.append("<!--");
+                        out.append(n.getValue());
+                        out.append("-->");
+                        newline();
+                        break;
+                    }
+                    case node_type::PROCESSING_INSTRUCTION_NODE:{
+                        indent(depth);
+                        out.append("<?");
+                        out.append(n.getValue());
+                        out.append("?>");
+                        newline();
+                        break;
+                    }
+                    default:{
+                        if(!n.getChildren().empty()){
+                            pending.push_back({&n, 0, depth});
+                        }
+                        break;
+                    }
+                }
+            }
+            void close(const frame& f){
+                if(f.n->getType() == node_type::ELEMENT_NODE){
+                    indent(f.depth);
+                    out.append("</");
+                    out.append(f.n->getValue());
+                    out.put('>');
+                    newline();
+                }
+            }
+
+            // Appends s with the characters of Set replaced by entities. Strings without any go out in one append.
+            template<const byte_set& Set>
+            void escaped(const std::string_view s){
+                std::size_t from = 0;
+                for(std::size_t i; (i = findFirstOf<Set>(s, from)) != std::string_view::npos; from = i + 1){
+                    out.append(s.substr(from, i - from));
+                    switch (s[i]){
+                        case '&':
+                            out.append("&amp;");
+                            break;
+                        case '<':
+                            out.append("&lt;");
+                            break;
+                        case '>':
+                            out.append("&gt;");
+                            break;
+                        default:
+                            out.append("&quot;");
+                            break;
+                    }
+                }
+                out.append(s.substr(from));
+            }
+            void indent(const std::size_t depth){
+                if(!indented){
+                    return;
+                }
+                if(spaces.size() < depth * 2){
+                    spaces.resize(depth * 2 + 64, ' ');
+                }
+                out.append(std::string_view(spaces.data(), depth * 2));
+            }
+            void newline(){
+                if(indented){
+                    out.put('\n');
+                }
+            }
+    };
+    using serializer = basic_serializer<output_buffer>;
+
+    // Whether writing n takes at least bytes, from the values and attributes of its nodes plus a few bytes of markup each.
+    // It stops walking as soon as the answer is known, so asking about a large tree costs no more than about a small one.
+    [[nodiscard]] inline bool outputReaches(const node& n, const std::size_t bytes){
+        std::size_t estimate = 0;
+        std::vector<const node*> pending{&n};
+        while(!pending.empty() && estimate < bytes){
+            const node* at = pending.back();
+            pending.pop_back();
+            // an element names itself in both tags
+            estimate += (at->getType() == node_type::ELEMENT_NODE ? 2 : 1) * at->getValue().size() + 5;
+            for(const auto& a : at->getAttributes()){
+                estimate += a.first.view().size() + a.second.view().size() + 4;
+            }
+            for(const auto& c : at->getChildren()){
+                pending.push_back(c.get());
+            }
+        }
+        return estimate >= bytes;
+    }
+
+    // Writes a tree on a thread pool, byte for byte what serializer writes. The top of the tree is split into the start
+    // and end tags of the elements on the way down and runs of whole sibling subtrees between them. A counting pass
+    // measures every piece, then the pieces are written at the same time, each into its own slice of one buffer.
+    // The tree is read from several threads, so it can't be lazily parsed.
+    class parallel_writer{
+        public:
+            // A buffer written to a stream holds at least this much output, except for the last one.
+            static constexpr std::size_t windowSize = std::size_t(64) << 20;
+            // Runs of subtrees per thread and window, so uneven runs still balance out.
+            static constexpr std::size_t piecesPerThread = 8;
+
+            parallel_writer(thread_pool& p, const output_format f) noexcept : pool(p), format(f), runs(p.size() * piecesPerThread){}
+
+            [[nodiscard]] std::string str(const node& n, const std::size_t depth){
+                measure(n, depth);
+                std::string s(total, '\0');
+                fill(0, pieces.size(), s.data());
+                return s;
+            }
+            // Writes the output in buffers of about windowSize, returns the number of bytes written.
+            std::size_t write(const node& n, const std::size_t depth, std::ostream& sink){
+                measure(n, depth);
+                if(total > windowSize){
+                    // every window needs pieces for all threads, so a tree larger than one is split and measured again
+                    runs *= total / windowSize + 1;
+                    measure(n, depth);
+                }
+                std::string buffer;
+                for(std::size_t first = 0, last; first < pieces.size(); first = last){
+                    std::size_t bytes = 0;
+                    for(last = first; last < pieces.size() && bytes < windowSize; ++last){
+                        bytes += pieces[last].size;
+                    }
+                    if(buffer.size() < bytes){
+                        buffer.resize(bytes);
+                    }
+                    fill(first, last, buffer.data());
+                    sink.write(buffer.data(), static_cast<std::streamsize>(bytes));
+                }
+                return total;
+            }
+        private:
+            thread_pool& pool;
+            output_format format;
+            std::size_t runs;// pieces of subtrees to split the tree into
+            std::vector<write_piece> pieces;
+            std::size_t total = 0;
+
+            // Splits the tree a level at a time: a run of several children is cut into shorter runs,
+            // a run of one child becomes the tags of that child around a run of its children.
+            void split(const node& n, const std::size_t depth){
+                pieces.clear();
+                if(n.getChildren().empty()){
+                    pieces.push_back({write_piece::part::start, &n, 0, 0, depth});
+                    return;
+                }
+                pieces.push_back({write_piece::part::start, &n, 0, 0, depth});
+                pieces.push_back({write_piece::part::children, &n, 0, n.getChildren().size(), depth});
+                pieces.push_back({write_piece::part::end, &n, 0, 0, depth});
+                std::vector<write_piece> below;
+                std::size_t count = 1;
+                // a chain of single children doesn't split, so only the top levels are tried
+                for(int level = 0; level < 64 && count < runs; ++level){
+                    below.clear();
+                    const std::size_t cuts = std::max<std::size_t>(2, runs / count);
+                    count = 0;
+                    for(const auto& p : pieces){
+                        const std::size_t length = p.last - p.first;
+                        if(p.what != write_piece::part::children || length == 0){
+                            below.push_back(p);
+                            continue;
+                        }
+                        if(length > 1){
+                            const std::size_t parts = std::min(length, cuts);
+                            for(std::size_t k = 0; k < parts; ++k){
+                                below.push_back({p.what, p.n, p.first + length * k / parts, p.first + length * (k + 1) / parts, p.depth});
+                            }
+                            count += parts;
+                            continue;
+                        }
+                        const node& c = *p.n->getChildren()[p.first];
+                        if(c.getChildren().empty()){
+                            below.push_back(p);
+                            ++count;
+                            continue;
+                        }
+                        const std::size_t childDepth = p.n->getType() == node_type::ELEMENT_NODE ? p.depth + 1 : p.depth;
+                        below.push_back({write_piece::part::start, &c, 0, 0, childDepth});
+                        below.push_back({write_piece::part::children, &c, 0, c.getChildren().size(), childDepth});
+                        below.push_back({write_piece::part::end, &c, 0, 0, childDepth});
+                        ++count;
+                    }
+                    if(below.size() == pieces.size()){
+                        break;// nothing left to split
+                    }
+                    pieces.swap(below);
+                }
+            }
+            void measure(const node& n, const std::size_t depth){
+                split(n, depth);
+                pool.parallelFor(pieces.size(), [this](const std::size_t i){
+                    output_counter counter;
+                    basic_serializer<output_counter>(counter, format).write(pieces[i]);
+                    pieces[i].size = counter.written();
+                });
+                total = std::accumulate(pieces.begin(), pieces.end(), std::size_t(0), [](const std::size_t sum, const write_piece& p){
+                    return sum + p.size;
+                });
+            }
+            // Writes the pieces [first, last) one after the other into at.
+            void fill(const std::size_t first, const std::size_t last, char* at){
+                std::vector<char*> starts(last - first);
+                for(std::size_t i = first; i < last; ++i){
+                    starts[i - first] = at;
+                    at += pieces[i].size;
+                }
+                pool.parallelFor(last - first, [&](const std::size_t i){
+                    output_slice slice(starts[i]);
+                    basic_serializer<output_slice>(slice, format).write(pieces[first + i]);
+                });
+            }
+    };
+};
+
+namespace miniXML{
+    inline std::string node::toString(int depth, details::output_format format) const {
+        details::output_buffer out;
+        details::serializer(out, format).write(*this, static_cast<std::size_t>(depth));
+        return std::move(out.str());
+    }
+};
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include "stats.hpp"
+
+// String type used for node values and attributes.
+// It either borrows characters that live elsewhere (the document content or its arena)
+// or owns a heap copy, which is what values set through the public API get.
+namespace miniXML::details{
+    class xml_string{
+        public:
+            xml_string() noexcept = default;
+            // Owning copy of s.
+            explicit xml_string(const std::string_view s){
+                assign(s);
+            }
+            // Non owning view, s has to outlive the xml_string.
+            [[nodiscard]] static xml_string borrow(const std::string_view s) noexcept {
+                xml_string r;
+                r.ptr = s.data();
+                r.len = s.size();
+                return r;
+            }
+            xml_string(const xml_string& other){
+                if(other.owned()){
+                    assign(other.view());
+                }else{
+                    ptr = other.ptr;
+                    len = other.len;
+                }
+            }
+            xml_string(xml_string&& other) noexcept : ptr(other.ptr), len(other.len){
+                other.ptr = nullptr;
+                other.len = 0;
+            }
+            xml_string& operator=(const xml_string& other){
+                if(this != &other){
+                    *this = xml_string(other);
+                }
+                return *this;
+            }
+            xml_string& operator=(xml_string&& other) noexcept {
+                if(this != &other){
+                    clear();
+                    ptr = other.ptr;
+                    len = other.len;
+                    other.ptr = nullptr;
+                    other.len = 0;
+                }
+                return *this;
+            }
+            ~xml_string(){
+                clear();
+            }
+
+            void assign(const std::string_view s){
+                char* copy = nullptr;
+                if(!s.empty()){
+                    copy = new char[s.size()];
+                    countAllocation(s.size());
+                    std::memcpy(copy, s.data(), s.size());
+                }
+                clear();
+                ptr = copy;
+                len = copy ? s.size() | ownedBit : 0;
+            }
+            void clear() noexcept {
+                if(owned()){
+                    delete[] ptr;
+                }
+                ptr = nullptr;
+                len = 0;
+            }
+
+            [[nodiscard]] std::string_view view() const noexcept {
+                return {ptr, size()};
+            }
+            operator std::string_view() const noexcept {
+                return view();
+            }
+            [[nodiscard]] std::string str() const {
+                return std::string(view());
+            }
+            [[nodiscard]] const char* data() const noexcept {
+                return ptr;
+            }
+            [[nodiscard]] std::size_t size() const noexcept {
+                return len & ~ownedBit;
+            }
+            [[nodiscard]] bool empty() const noexcept {
+                return size() == 0;
+            }
+            [[nodiscard]] bool owned() const noexcept {
+                return (len & ownedBit) != 0;
+            }
+
+            friend bool operator==(const xml_string& a, const xml_string& b) noexcept {
+                return a.view() == b.view();
+            }
+            friend bool operator!=(const xml_string& a, const xml_string& b) noexcept {
+                return a.view() != b.view();
+            }
+            friend bool operator==(const xml_string& a, const std::string_view b) noexcept {
+                return a.view() == b;
+            }
+            friend bool operator!=(const xml_string& a, const std::string_view b) noexcept {
+                return a.view() != b;
+            }
+            friend std::ostream& operator<<(std::ostream& os, const xml_string& s){
+                return os << s.view();
+            }
+        private:
+            static constexpr std::size_t ownedBit = std::size_t(1) << (sizeof(std::size_t) * 8 - 1);
+
+            const char* ptr = nullptr;
+            std::size_t len = 0;// the top bit marks an owned buffer
+    };
+};
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include <iostream>
+#include <string>
+#include "..\include\miniXML\document.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+int main(){
+    const std::string xml = "<item zeta=\"1\" alpha=\"2\" mid=\"3\" beta=\"4\" omega=\"5\" gamma=\"6\"/>";
+    for(const auto engine : {parse_engine::tokens, parse_engine::direct}){
+        document d;
+        d.parseFromString(xml, engine);
+        if(d.rootNode().toString(0, output_format::compact) != xml){
+            std::cout << "Attributes weren't written in source order by engine " << static_cast<int>(engine) << "\n";
+            return 1;
+        }
+    }
+
+    //replacing keeps the position, deleting keeps the order of the rest
+    node n(node_type::ELEMENT_NODE, "item");
+    for(const char* name : {"a", "b", "c", "d", "e"}){
+        n.appendAttribute(name, name);
+    }
+    n.appendAttribute("b", "replaced");
+    if(!n.deleteAttribute("a") || !n.deleteAttribute("d") || n.deleteAttribute("missing")){
+        std::cout << "deleteAttribute reported the wrong result\n";
+        return 1;
+    }
+    if(n.toString(0, output_format::compact) != "<item b=\"replaced\" c=\"c\" e=\"e\"/>" || n.getAttribute("e") != "e" || n.getAttribute("a")){
+        std::cout << "The attributes don't match after the changes: " << n.toString() << "\n";
+        return 1;
+    }
+    n.clearAttributes();
+    n.appendAttribute("only", "1");
+    if(n.getAttributes().size() != 1 || n.getAttribute("only") != "1"){
+        std::cout << "The attributes don't match after clearAttributes\n";
+        return 1;
+    }
+    std::cout << "Attributes keep their order\n";
+    return 0;
+}
\ No newline at end of file
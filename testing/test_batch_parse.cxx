@@ -0,0 +1,107 @@
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "..\include\miniXML\batch.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+std::string message(const std::size_t i){
+    const std::string n = std::to_string(i);
+    return "<message id=\"" + n + "\"><from>sender " + n + "</from><body>text   of " + n + "</body></message>";
+}
+
+int main(){
+    std::vector<std::string> messages;
+    for(std::size_t i = 0; i < 2000; ++i){
+        messages.push_back(i % 500 == 7 ? "<message><from>broken</body></message>" : message(i));
+    }
+    std::vector<std::string_view> inputs(messages.begin(), messages.end());
+
+    for(const auto engine : {parse_engine::tokens, parse_engine::direct, parse_engine::parallel, parse_engine::lazy}){
+        for(std::size_t threads = 1; threads <= 4; ++threads){
+            thread_pool pool(threads);
+            batch_parser batch(engine, &pool);
+            //the second round reuses the documents of the first
+            for(int round = 0; round < 2; ++round){
+                batch.parse(inputs);
+                if(batch.size() != inputs.size()){
+                    std::cout << "The batch has " << batch.size() << " results for " << inputs.size() << " inputs\n";
+                    return 1;
+                }
+                for(std::size_t i = 0; i < inputs.size(); ++i){
+                    if(i % 500 == 7){
+                        if(!batch.getError(i)){
+                            std::cout << "The broken input " << i << " was accepted\n";
+                            return 1;
+                        }
+                        try{
+                            (void)batch.getDocument(i);
+                            std::cout << "getDocument() of a failed input didn't throw\n";
+                            return 1;
+                        }catch(const std::runtime_error&){}
+                        continue;
+                    }
+                    document expected;
+                    expected.parseFromString(inputs[i], parse_engine::direct);
+                    if(batch.getDocument(i).rootNode().toString() != expected.rootNode().toString()){
+                        std::cout << "Result " << i << " with " << threads << " threads doesn't belong to its input\n";
+                        return 1;
+                    }
+                }
+            }
+        }
+    }
+
+    //a smaller batch after a larger one
+    batch_parser batch;
+    batch.parse(inputs);
+    batch.parse({inputs[1], inputs[2]});
+    if(batch.size() != 2 || batch.getDocument(1).rootNode().findChild("message")->getAttribute("id") != "2"){
+        std::cout << "A smaller batch kept results of the previous one\n";
+        return 1;
+    }
+
+    //documents with ever new names don't grow the symbol tables of the reused documents without bound
+    batch_parser varied;
+    std::vector<std::string> named(4);
+    for(std::size_t round = 0; round < 40; ++round){
+        for(std::size_t k = 0; k < named.size(); ++k){
+            named[k] = "<r>";
+            for(std::size_t n = 0; n < 200; ++n){
+                named[k] += "<e" + std::to_string(round) + "_" + std::to_string(n) + "/>";
+            }
+            named[k] += "</r>";
+        }
+        varied.parse(std::vector<std::string_view>(named.begin(), named.end()));
+        for(std::size_t k = 0; k < named.size(); ++k){
+            if(varied.getDocument(k).symbols().size() > document::maxReusedSymbols + 201){
+                std::cout << "A reused document kept " << varied.getDocument(k).symbols().size() << " names\n";
+                return 1;
+            }
+        }
+    }
+
+    //every worker gets its own slot
+    thread_pool pool(4);
+    std::vector<std::atomic<int>> busy(pool.size());
+    std::atomic<bool> shared{false};
+    pool.parallelFor(1000, [&](const std::size_t, const std::size_t worker){
+        if(worker >= pool.size()){
+            shared = true;
+            return;
+        }
+        if(busy[worker].fetch_add(1) != 0){
+            shared = true;
+        }
+        busy[worker].fetch_sub(1);
+    });
+    if(shared){
+        std::cout << "Two threads ran with the same worker slot\n";
+        return 1;
+    }
+
+    std::cout << "Batches are parsed in input order\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <string>
+#include "..\include\miniXML\document.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+//the children named v, found by walking the children
+std::size_t count(const node& n, std::string_view v){
+    std::size_t c = 0;
+    for(const auto& child : n.getChildren()){
+        c += child->getValue() == v;
+    }
+    return c;
+}
+
+bool consistent(node& n){
+    for(const std::string_view v : {"a", "b", "c", "d", "missing"}){
+        const auto found = n.findChildren(v);
+        if(found.size() != count(n, v)){
+            return false;
+        }
+        for(std::size_t i = 1; i < found.size(); ++i){
+            if(found[i - 1] == found[i]){
+                return false;
+            }
+        }
+        if(n.findChild(v) != (found.empty() ? nullptr : found.front())){
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(){
+    node parent(node_type::ELEMENT_NODE, "parent");
+    const char* names[] = {"a", "b", "c"};
+    for(int i = 0; i < 3000; ++i){
+        parent.appendChild(std::make_unique<node>(node_type::ELEMENT_NODE, names[i % 3]));
+    }
+    //the first lookup builds the index, the next ones have to see every change
+    if(!consistent(parent)){
+        std::cout << "Lookups don't match the children\n";
+        return 1;
+    }
+    node* added = parent.appendChild(std::make_unique<node>(node_type::ELEMENT_NODE, "d"));
+    if(parent.findChild("d") != added || !consistent(parent)){
+        std::cout << "An appended child wasn't found\n";
+        return 1;
+    }
+    node* first = parent.findChild("a");
+    if(!parent.deleteChild(first) || parent.findChild("a") == first || !consistent(parent)){
+        std::cout << "A deleted child was still found\n";
+        return 1;
+    }
+    node* renamed = parent.findChild("b");
+    renamed->setValue("d");
+    if(parent.findChildren("d").size() != 2 || parent.findChild("b") == renamed || !consistent(parent)){
+        std::cout << "A renamed child was found by its old name\n";
+        return 1;
+    }
+    if(!added->deleteFromParent() || !consistent(parent)){
+        std::cout << "Lookups don't match after deleteFromParent\n";
+        return 1;
+    }
+    parent.clearChildren();
+    parent.appendChild(std::make_unique<node>(node_type::ELEMENT_NODE, "a"));
+    if(parent.findChildren("a").size() != 1 || !consistent(parent)){
+        std::cout << "Lookups don't match after clearChildren\n";
+        return 1;
+    }
+    std::cout << "Indexed lookups match the children\n";
+    return 0;
+}
\ No newline at end of file
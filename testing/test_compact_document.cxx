@@ -0,0 +1,99 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "..\include\miniXML\compact_document.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+//ids of the nodes a query selects on the tree and on the compact form, which have to be the same
+bool sameSelection(const std::string& path, const document& d, const compact_document& c){
+    const query q(path);
+    std::vector<std::string> expected, actual;
+    for(const node* n : q.select(d.rootNode())){
+        expected.emplace_back(n->getAttribute("id").value_or(n->getValue()));
+    }
+    for(const auto i : c.select(q)){
+        actual.emplace_back(c.getAttribute(i, "id").value_or(c.getValue(i)));
+    }
+    if(expected != actual){
+        std::cout << path << " selected different nodes on the compact document\n";
+        return false;
+    }
+    return true;
+}
+
+int main(){
+    std::ifstream in("file.xml");
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string xml = buffer.str();
+
+    //parsed straight into the arrays, the nodes are those of the direct engine
+    document tree;
+    tree.parseFromString(xml, parse_engine::direct);
+    compact_document parsed;
+    parsed.parseFromString(xml);
+    document back;
+    parsed.toDocument(back);
+    if(back.rootNode().toString() != tree.rootNode().toString()){
+        std::cout << "The compact document doesn't hold the parsed tree\n";
+        return 1;
+    }
+    //and converted from a tree
+    const compact_document converted(tree.rootNode());
+    document again;
+    converted.toDocument(again);
+    if(again.rootNode().toString() != tree.rootNode().toString() || converted.size() != parsed.size()){
+        std::cout << "The tree didn't convert to a compact document and back\n";
+        return 1;
+    }
+
+    //navigation by index, nodes are in document order
+    const auto note = parsed.select(query("/note"));
+    if(note.size() != 1 || parsed.getType(note[0]) != node_type::ELEMENT_NODE || parsed.getParent(note[0]) != 0){
+        std::cout << "The root element wasn't found\n";
+        return 1;
+    }
+    const auto from = parsed.getNextSibling(parsed.getFirstChild(note[0]));
+    if(parsed.getValue(from) != "from" || parsed.getAttributeCount(from) != 1 || parsed.getAttribute(from, 0).second != "Bob"
+        || parsed.getSymbol(from) != parsed.findSymbol("from").id || parsed.getFirstChild(from) != compact_document::npos){
+        std::cout << "The children of the root element aren't linked\n";
+        return 1;
+    }
+    std::size_t elements = 0;
+    for(compact_document::index i = note[0]; i < parsed.getSubtreeEnd(note[0]); ++i){
+        elements += parsed.getType(i) == node_type::ELEMENT_NODE;
+    }
+    if(elements != 5 || parsed.getSubtreeEnd(note[0]) != parsed.size() - 1){
+        std::cout << "The subtree of the root element isn't contiguous\n";
+        return 1;
+    }
+
+    //queries select the same nodes as on the tree
+    document catalog;
+    const std::string items =
+        "<catalog>"
+        "<item id='a' kind='book'><name>First</name></item>"
+        "<item id='b'><name>Second</name><item id='b1' kind='book'><name>Nested</name></item></item>"
+        "<group id='g'><item id='c' kind='book'><name>Third</name></item><item id='d'/><item id='e' kind='book'/></group>"
+        "</catalog>";
+    catalog.parseFromString(items, parse_engine::direct);
+    compact_document compact;
+    compact.parseFromString(items);
+    for(const char* path : {"/catalog/item", "//item", "//item[@kind='book']", "//item[@kind]/name/text()", "/catalog/item[2]", "//item[1]",
+        "//item[@kind='book'][2]", "/catalog/*", "//group//name/text()", "//item//item", "//item[@missing]", "/nothing"}){
+        if(!sameSelection(path, catalog, compact)){
+            return 1;
+        }
+    }
+    const auto group = compact.select(query("//group"));
+    if(group.size() != 1 || compact.select(query("item"), group[0]).size() != 3){
+        std::cout << "Relative queries don't start at the context\n";
+        return 1;
+    }
+    std::cout << "The compact document holds the same nodes as the tree\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#include <iostream>
+#include "..\include\miniXML\document.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+int main(){
+    document d("file.xml", parse_engine::direct);
+
+    //compact output has no whitespace between the nodes
+    const std::string compact = d.rootNode().toString(0, output_format::compact);
+    std::cout << compact << '\n';
+    d.writeToFile("compact.xml", 0, output_format::compact);
+
+    //reading it back has to give the same tree
+    document again("compact.xml", parse_engine::direct);
+    if(again.rootNode().toString() != d.rootNode().toString()){
+        std::cout << "The compact output doesn't read back to the same tree\n";
+        return 1;
+    }
+    std::cout << "The compact output reads back to the same tree\n";
+    return 0;
+}
\ No newline at end of file
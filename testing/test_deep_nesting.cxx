@@ -0,0 +1,91 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "..\include\miniXML\incremental.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+// Far deeper than a recursive parser, writer or destructor gets on a default stack.
+constexpr std::size_t levels = 100000;
+
+std::string nested(const std::size_t depth){
+    std::string xml;
+    for(std::size_t d = 0; d < depth; ++d){
+        xml += "<a>";
+    }
+    xml += "<b/>";
+    for(std::size_t d = 0; d < depth; ++d){
+        xml += "</a>";
+    }
+    return xml;
+}
+
+bool tooDeep(const std::string& xml, const parse_engine engine, const std::size_t limit){
+    document d;
+    d.setMaxDepth(limit);
+    try{
+        d.parseFromString(xml, engine);
+    }catch(const std::runtime_error&){
+        return true;
+    }
+    return false;
+}
+
+int main(){
+    const std::string xml = nested(levels);
+    thread_pool pool(4);
+    for(const auto engine : {parse_engine::tokens, parse_engine::direct, parse_engine::parallel, parse_engine::lazy}){
+        {
+            document d;
+            d.setThreadPool(&pool);
+            d.setMaxDepth(levels + 1);
+            d.parseFromString(xml, engine);
+            std::size_t depth = 0;
+            const node* n = &d.rootNode();
+            while(!n->getChildren().empty()){
+                n = n->getChildren().front().get();
+                ++depth;
+            }
+            if(depth != levels + 1 || n->getValue() != "b"){
+                std::cout << "The nested elements weren't parsed\n";
+                return 1;
+            }
+            if(d.rootNode().toString(0, output_format::compact) != xml){
+                std::cout << "The nested elements weren't written back\n";
+                return 1;
+            }
+            d.writeToFile("deep.xml", 0, output_format::compact);
+        }// the tree is destroyed here
+        document written("deep.xml", engine, load_mode::read, levels + 1);
+        if(written.rootNode().toString(0, output_format::compact) != xml){
+            std::cout << "The written file doesn't read back\n";
+            return 1;
+        }
+    }
+
+    // the limit fails cleanly with every engine, the empty element counts as a level
+    const std::string small = nested(50);
+    for(const auto engine : {parse_engine::tokens, parse_engine::direct, parse_engine::parallel, parse_engine::lazy}){
+        if(!tooDeep(small, engine, 50) || tooDeep(small, engine, 51)){
+            std::cout << "The depth limit wasn't enforced\n";
+            return 1;
+        }
+    }
+    if(!tooDeep(xml, parse_engine::parallel, levels)){
+        std::cout << "The depth limit wasn't enforced across ranges\n";
+        return 1;
+    }
+    document d;
+    d.setMaxDepth(50);
+    incremental_parser p(d);
+    try{
+        p.feed(small);
+        p.finish();
+        std::cout << "The depth limit wasn't enforced by the incremental parser\n";
+        return 1;
+    }catch(const std::runtime_error&){
+    }
+    std::cout << "Deeply nested documents are parsed, written and destroyed\n";
+    return 0;
+}
\ No newline at end of file
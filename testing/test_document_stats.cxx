@@ -0,0 +1,96 @@
+#define MINIXML_STATS 1
+#include <iostream>
+#include <cstdio>
+#include <thread>
+#include "..\include\miniXML\incremental.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+bool check(const document_stats& s, const std::size_t bytes, const char* engine){
+    const bool ok = s.bytesScanned == bytes && s.tokens > 0
+        && s.nodeCount(node_type::DOCUMENT_NODE) == 1 && s.nodeCount(node_type::ELEMENT_NODE) == 4 && s.nodeCount(node_type::TEXT_NODE) == 2
+        && s.nodeCount(node_type::COMMENT_NODE) == 1 && s.nodeCount(node_type::PROCESSING_INSTRUCTION_NODE) == 1
+        && s.attributes == 3 && s.maxDepth == 4 && s.buildSeconds > 0;
+    if(!ok){
+        std::cout << "Wrong stats for the " << engine << " engine: " << s.tokens << " tokens, " << s.attributes << " attributes, depth " << s.maxDepth << "\n";
+    }
+    return ok;
+}
+
+int main(){
+    const std::string xml = "<?xml version='1.0'?><note id='1'><!-- c --><to lang='en' kind='a'>Alice</to><body><p>Hi</p></body></note>";
+    document d;
+    d.parseFromString(xml, parse_engine::tokens);
+    if(!check(d.stats(), xml.size(), "token")){
+        return 1;
+    }
+    if(d.stats().tokenizeSeconds <= 0 || d.stats().heapNodes != 8 || d.stats().allocations < 8 || d.stats().bytesAllocated < 8 * sizeof(node)){
+        std::cout << "The token engine's nodes weren't counted as heap nodes\n";
+        return 1;
+    }
+    d.parseFromString(xml, parse_engine::direct);
+    if(!check(d.stats(), xml.size(), "direct")){
+        return 1;
+    }
+    if(d.stats().heapNodes != 0 || d.stats().arenaBlocks == 0){
+        std::cout << "The direct engine's nodes weren't counted as arena nodes\n";
+        return 1;
+    }
+    if(d.stats().allocations != d.stats().arenaBlocks || d.stats().bytesAllocated != d.stats().arenaBytes){
+        std::cout << "The direct engine allocated " << d.stats().allocations << " times beside its " << d.stats().arenaBlocks << " arena blocks\n";
+        return 1;
+    }
+    //a reused document takes its blocks from the previous parse
+    d.setReuseMemory(true);
+    d.parseFromString(xml, parse_engine::direct);
+    d.parseFromString(xml, parse_engine::direct);
+    if(d.stats().allocations != 0 || d.stats().arenaBlocks == 0){
+        std::cout << "A reused document counted " << d.stats().allocations << " allocations\n";
+        return 1;
+    }
+    d.setReuseMemory(false);
+    d.parseFromString(xml, parse_engine::parallel);
+    if(!check(d.stats(), xml.size(), "parallel")){
+        return 1;
+    }
+    document fed;
+    incremental_parser parser(fed);
+    parser.feed(xml.substr(0, 30));
+    parser.feed(xml.substr(30));
+    parser.finish();
+    if(fed.stats().bytesScanned != xml.size() || fed.stats().nodeCount(node_type::ELEMENT_NODE) != 4 || fed.stats().tokens == 0){
+        std::cout << "Wrong stats for the incremental parser\n";
+        return 1;
+    }
+
+    d.writeToFile("stats.xml", 0, output_format::compact);
+    const std::size_t size = d.rootNode().toString(0, output_format::compact).size();
+    if(d.stats().bytesWritten != size || d.stats().writeSeconds <= 0){
+        std::cout << "Wrong stats for writeToFile\n";
+        return 1;
+    }
+    //toString() counts as a write, writes on several threads add up
+    const double seconds = d.stats().writeSeconds;
+    std::thread other([&d]{
+        for(int i = 0; i < 100; ++i){
+            (void)d.toString(0, output_format::compact);
+        }
+    });
+    for(int i = 0; i < 100; ++i){
+        (void)d.toString(0, output_format::compact);
+    }
+    other.join();
+    if(d.stats().bytesWritten != 201 * size || d.stats().writeSeconds <= seconds){
+        std::cout << "Wrong stats for toString\n";
+        return 1;
+    }
+    d.parseFromString(xml, parse_engine::direct);
+    if(d.stats().bytesWritten != 0){
+        std::cout << "Parsing didn't clear the write stats\n";
+        return 1;
+    }
+    std::remove("stats.xml");
+    std::cout << "Stats match the document\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <string>
+#include "..\include\miniXML\compact_document.hpp"
+#include "..\include\miniXML\incremental.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+const std::string xml =
+    "<?xml version=\"1.0\"?>\n"
+    "<shop name='Tom &amp; Jerry &quot;Ltd&quot; &apos;s' plain=\"nothing here\">\n"
+    "  <item note=\"a &lt; b &gt; c\">Fish &amp; Chips &#233;t&#xE9; &#x1F600;</item>\n"
+    "  <item>AT&T &unknown; &#xZZ; &#0; &#x110000; &amp</item>\n"
+    "  <item>  spread   over\n    lines &lt;quoted&gt;  </item>\n"
+    "</shop>\n";
+
+//checks the decoded values of the document above
+bool decoded(const node& root){
+    const node* shop = root.findChild("shop");
+    if(!shop || shop->getAttribute("name") != "Tom & Jerry \"Ltd\" 's" || shop->getAttribute("plain") != "nothing here"){
+        return false;
+    }
+    const auto& items = shop->getChildren();
+    return items.size() == 3
+        && items[0]->getAttribute("note") == "a < b > c"
+        && items[0]->getChildren()[0]->getValue() == "Fish & Chips \xC3\xA9t\xC3\xA9 \xF0\x9F\x98\x80"
+        && items[1]->getChildren()[0]->getValue() == "AT&T &unknown; &#xZZ; &#0; &#x110000; &amp"
+        && items[2]->getChildren()[0]->getValue() == "spread over lines <quoted>";
+}
+
+int main(){
+    for(const auto engine : {parse_engine::tokens, parse_engine::direct, parse_engine::parallel, parse_engine::lazy}){
+        document d;
+        d.parseFromString(xml, engine);
+        if(!decoded(d.rootNode())){
+            std::cout << "Entities weren't decoded by every engine\n";
+            return 1;
+        }
+        //writing escapes them again, so the output parses back into the same values
+        document again;
+        again.parseFromString(d.rootNode().toString(), engine);
+        if(!decoded(again.rootNode()) || again.rootNode().toString() != d.rootNode().toString()){
+            std::cout << "Escaped output doesn't parse back into the same document\n";
+            return 1;
+        }
+    }
+
+    //CDATA is kept as it is but escaped on output, the token engine doesn't read CDATA sections
+    for(const auto engine : {parse_engine::direct, parse_engine::lazy}){
+        document d;
+        d.parseFromString("<code><![CDATA[if(a < b && c) &amp;]]></code>", engine);
+        if(d.rootNode().findChild("code")->getChildren()[0]->getValue() != "if(a < b && c) &amp;"
+            || d.rootNode().toString(0, output_format::compact) != "<code>if(a &lt; b &amp;&amp; c) &amp;amp;</code>"){
+            std::cout << "CDATA wasn't kept as it is\n";
+            return 1;
+        }
+    }
+
+    {
+        document d;
+        incremental_parser parser(d);
+        for(const char c : xml){
+            parser.feed(std::string_view(&c, 1));
+        }
+        parser.finish();
+        if(!decoded(d.rootNode())){
+            std::cout << "Entities weren't decoded by the reader\n";
+            return 1;
+        }
+        compact_document c;
+        c.parseFromString(xml);
+        document fromCompact;
+        c.toDocument(fromCompact);
+        const compact_document fromTree(d.rootNode());
+        if(!decoded(fromCompact.rootNode()) || fromTree.getAttribute(fromTree.select(query("/shop"))[0], "name") != "Tom & Jerry \"Ltd\" 's"){
+            std::cout << "Entities weren't decoded by compact_document\n";
+            return 1;
+        }
+    }
+
+    //values without references stay views into the input
+    {
+        document d;
+        d.parseFromString("<a x=\"plain\">text</a>", parse_engine::direct);
+        const node* a = d.rootNode().findChild("a");
+        if(a->getChildren()[0]->getValue().data() - a->getAttribute("x")->data() != 7){
+            std::cout << "A value without references was copied\n";
+            return 1;
+        }
+    }
+
+    //a parsed tag with nothing to decode can still have a '"' in a value, and values added later need escaping too
+    for(const auto engine : {parse_engine::direct, parse_engine::lazy}){
+        document parsed;
+        parsed.parseFromString("<a q='say \"hi\"' r=\"x\"/><b r=\"x\"/>", engine);
+        parsed.rootNode().getChildren()[1]->appendAttribute("s", "<&>");
+        if(parsed.rootNode().toString(0, output_format::compact) != "<a q=\"say &quot;hi&quot;\" r=\"x\"/><b r=\"x\" s=\"&lt;&amp;&gt;\"/>"){
+            std::cout << "Parsed attributes weren't escaped: " << parsed.rootNode().toString(0, output_format::compact) << "\n";
+            return 1;
+        }
+    }
+
+    //values set through the API are escaped, long ones go through the vector kernels
+    document d;
+    node* root = d.rootNode().appendChild(std::make_unique<node>(node_type::ELEMENT_NODE, "r"));
+    const std::string filler(100, 'x');
+    root->appendAttribute("q", filler + "\"<&>" + filler);
+    root->appendChild(std::make_unique<node>(node_type::TEXT_NODE, filler + "a<b&c>d\"" + filler));
+    const std::string out = d.rootNode().toString(0, output_format::compact);
+    if(out != "<r q=\"" + filler + "&quot;&lt;&amp;&gt;" + filler + "\">" + filler + "a&lt;b&amp;c&gt;d\"" + filler + "</r>"){
+        std::cout << "Values weren't escaped: " << out << "\n";
+        return 1;
+    }
+
+    std::cout << "Entities are decoded and escaped\n";
+    return 0;
+}
\ No newline at end of file
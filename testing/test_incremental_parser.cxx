@@ -0,0 +1,71 @@
+#include <iostream>
+#include <fstream>
+#include "..\include\miniXML\incremental.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+int main(){
+    document expected("file.xml", parse_engine::direct);
+    std::ifstream file("file.xml", std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    //feed the file in chunks of every size, so the boundaries fall inside tags, values and comments
+    for(std::size_t chunk = 1; chunk <= content.size(); ++chunk){
+        document d;
+        incremental_parser parser(d);
+        for(std::size_t i = 0; i < content.size(); i += chunk){
+            parser.feed(std::string_view(content).substr(i, chunk));
+        }
+        parser.finish();
+        if(d.rootNode().toString() != expected.rootNode().toString()){
+            std::cout << "Chunks of " << chunk << " bytes produced a different tree\n";
+            return 1;
+        }
+    }
+
+    //the tree grows before the input is complete
+    document partial;
+    incremental_parser parser(partial);
+    parser.feed("<note><from id='Bob'/><to id='Al");
+    const node* note = partial.rootNode().findChild(std::string("note"));
+    if(!note || !note->findChild(std::string("from")) || note->findChild(std::string("to"))){
+        std::cout << "The complete elements weren't added while waiting for input\n";
+        return 1;
+    }
+    parser.feed("ice'/></note>");
+    parser.finish();
+    std::cout << partial.rootNode().toString();
+
+    //markups of several MB arriving in small chunks are parsed, and searched once rather than again with every chunk
+    const std::string text(16 << 20, 'x');
+    const std::string value(4 << 20, 'v');
+    const std::string big = "<a><b>" + text + "</b><!--" + text + "--><c v=\"" + value + "\"/></a>";
+    document large;
+    incremental_parser chunks(large);
+    for(std::size_t i = 0; i < big.size(); i += 4096){
+        chunks.feed(std::string_view(big).substr(i, 4096));
+    }
+    chunks.finish();
+    const node* a = large.rootNode().findChild("a");
+    if(!a || a->findChild("b")->getChildren()[0]->getValue().size() != text.size() || a->findChild("c")->getAttribute("v") != value
+        || a->findChild(node_type::COMMENT_NODE)->getValue().size() != text.size()){
+        std::cout << "Large markups fed in chunks weren't parsed\n";
+        return 1;
+    }
+    reader events;
+    event e;
+    for(std::size_t i = 0; i < big.size(); i += 4096){
+        events.feed(std::string_view(big).substr(i, 4096));
+        while(events.next(e)){}
+    }
+    events.finish();
+    while(events.next(e)){}
+    // a terminator straddling two chunks has its first bytes searched twice, a search from the start would be quadratic
+    if(events.bytesSearched() > big.size() + 2 * (big.size() / 4096 + 1) || events.bytesMoved() > big.size()){
+        std::cout << "Feeding large markups in chunks searched " << events.bytesSearched() << " and moved " << events.bytesMoved()
+            << " bytes of " << big.size() << "\n";
+        return 1;
+    }
+    std::cout << "Incremental parsing matches the document\n";
+    return 0;
+}
\ No newline at end of file
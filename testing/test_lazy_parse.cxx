@@ -0,0 +1,69 @@
+#include <iostream>
+#include <string>
+#include "..\include\miniXML\query.hpp"
+#include "..\include\miniXML\document.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+int main(){
+    //the lazy engine builds the same tree as the direct one once everything is touched
+    document direct("file.xml", parse_engine::direct);
+    document lazy("file.xml", parse_engine::lazy);
+    if(lazy.rootNode().toString() != direct.rootNode().toString()){
+        std::cout << "The lazy engine built a different tree\n";
+        return 1;
+    }
+
+    //a feed with a header and many entries, reading the header doesn't parse the entries
+    std::string xml = "<?xml version='1.0'?><feed><header id='h'><title>Lazy feed</title></header>";
+    for(int i = 0; i < 10000; ++i){
+        xml += "<entry id='" + std::to_string(i) + "'><title>Entry " + std::to_string(i) + "</title><body>Text of <b>the</b> entry</body></entry>";
+    }
+    xml += "</feed>";
+    document feed;
+    feed.parseFromString(xml, parse_engine::lazy);
+    const node* header = feed.rootNode().findChild("feed")->findChild("header");
+    if(!header || header->getAttribute("id") != "h" || header->findChild("title")->getChildren().front()->getValue() != "Lazy feed"){
+        std::cout << "The header wasn't read\n";
+        return 1;
+    }
+    std::size_t materialized = 0;
+    for(const auto& entry : feed.rootNode().findChild("feed")->findChildren("entry")){
+        materialized += entry->getChildren().size();// only counts what is there, the entries are parsed here
+    }
+    if(materialized != 20000){
+        std::cout << "The entries weren't parsed on access\n";
+        return 1;
+    }
+    document eager;
+    eager.parseFromString(xml, parse_engine::direct);
+    if(feed.rootNode().toString() != eager.rootNode().toString() || query("//entry[@id='42']/body/b").count(feed.rootNode()) != 1){
+        std::cout << "The lazily parsed feed differs from the eager one\n";
+        return 1;
+    }
+
+    //nodes can be modified before or after they are parsed
+    document edited;
+    edited.parseFromString("<a><b x='1'><c/></b><d/></a>", parse_engine::lazy);
+    node* a = edited.rootNode().findChild("a");
+    a->appendChild(std::make_unique<node>(node_type::ELEMENT_NODE, "e"));
+    node* b = a->findChild("b");
+    b->appendAttribute("y", "2");
+    if(edited.rootNode().toString(0, output_format::compact) != "<a><b x=\"1\" y=\"2\"><c/></b><d/><e/></a>"){
+        std::cout << "Changes to lazy nodes were lost\n";
+        return 1;
+    }
+
+    //markup errors are still found when the document is opened
+    for(const char* bad : {"<a><b></c></a>", "<a><b><c></b></c></a>"}){
+        try{
+            document d;
+            d.parseFromString(bad, parse_engine::lazy);
+            std::cout << bad << " was accepted\n";
+            return 1;
+        }catch(const std::runtime_error&){}
+    }
+    std::cout << "Lazily parsed nodes are parsed on first access\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include "..\include\miniXML\document.hpp"
+#if !defined(_WIN32)
+    #include <sys/stat.h>
+#endif
+
+using namespace miniXML;
+using namespace miniXML::details;
+int main(){
+    //the mapped document parses straight out of the mapping
+    document read("file.xml", parse_engine::direct, load_mode::read);
+    document mapped("file.xml", parse_engine::direct, load_mode::map);
+    document populated("file.xml", parse_engine::tokens, load_mode::map_populate);
+
+    const std::string expected = read.rootNode().toString();
+    std::cout << mapped.rootNode().toString();
+    if(mapped.rootNode().toString() != expected || populated.rootNode().toString() != expected){
+        std::cout << "The mapped documents differ from the read one\n";
+        return 1;
+    }
+#if !defined(_WIN32)
+    //a pipe can't seek, so it has no size up front and is read as it comes
+    std::stringstream source;
+    source << std::ifstream("file.xml", std::ios::binary).rdbuf();
+    const std::string fifo = "memory_mapped_file.fifo";
+    std::remove(fifo.c_str());
+    if(::mkfifo(fifo.c_str(), 0600) != 0){
+        std::cout << "Failed to create a pipe\n";
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);// a failed read may leave the writer without a reader
+    std::thread writer([&fifo, text = source.str()]{
+        std::ofstream(fifo, std::ios::binary) << text;
+    });
+    std::string piped;
+    try{
+        piped = document(fifo, parse_engine::direct, load_mode::read).rootNode().toString();
+    }catch(const std::exception& e){
+        std::cout << "Failed to read from a pipe: " << e.what() << "\n";
+        std::ifstream(fifo, std::ios::binary).ignore(std::numeric_limits<std::streamsize>::max());// lets the writer finish
+    }
+    writer.join();
+    std::remove(fifo.c_str());
+    if(piped != expected){
+        std::cout << "The document read from a pipe differs from the read one\n";
+        return 1;
+    }
+#endif
+    std::cout << "Mapped and read documents are the same\n";
+    return 0;
+}
\ No newline at end of file
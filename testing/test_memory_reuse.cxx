@@ -0,0 +1,112 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include "..\include\miniXML\document.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+std::atomic<std::size_t> allocations{0};
+
+void* operator new(const std::size_t size){
+    ++allocations;
+    if(void* p = std::malloc(size ? size : 1)){
+        return p;
+    }
+    throw std::bad_alloc();
+}
+// GCC inlines this into callers and then reports free() on a pointer from a new expression, which here comes from malloc()
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+void operator delete(void* p, std::size_t) noexcept {
+    operator delete(p);
+}
+
+//messages of the same shape with different values
+std::string message(const std::size_t i){
+    const std::string n = std::to_string(i * 7919);
+    std::string xml = "<?xml version='1.0' encoding=\"UTF-8\"?>\n<order id=\"" + n + "\" state='open'>\n";
+    xml += "  <!-- order   " + n + " -->\n";
+    for(std::size_t k = 0; k < 20 + i % 3; ++k){
+        xml += "  <line sku=\"" + std::to_string(k) + "\" count='" + n + "'>item\n      number " + n + "</line>\n";
+    }
+    xml += "  <note><![CDATA[<raw " + n + ">]]></note>\n  <empty/>\n</order>\n";
+    return xml;
+}
+
+int main(){
+    for(const auto engine : {parse_engine::direct, parse_engine::parallel, parse_engine::lazy}){
+        document d;
+        d.setReuseMemory(true);
+        std::size_t steady = 0;
+        for(std::size_t i = 0; i < 200; ++i){
+            const std::string xml = message(i);
+            document expected;
+            expected.parseFromString(xml, parse_engine::direct);
+            const std::string reference = expected.rootNode().toString();
+
+            const std::size_t before = allocations.load();
+            d.parseFromString(xml, engine);
+            if(i >= 10){
+                steady += allocations.load() - before;
+            }
+            if(d.rootNode().toString() != reference){
+                std::cout << "Message " << i << " parsed into reused memory doesn't match\n";
+                return 1;
+            }
+        }
+        if(engine == parse_engine::direct && steady != 0){
+            std::cout << "Parsing into a reused document allocated " << steady << " times\n";
+            return 1;
+        }
+    }
+
+    //without reuse every parse allocates
+    document fresh;
+    fresh.parseFromString(message(0), parse_engine::direct);
+    const std::size_t before = allocations.load();
+    fresh.parseFromString(message(1), parse_engine::direct);
+    if(allocations.load() == before){
+        std::cout << "Parsing without reuse didn't allocate, the test can't see allocations\n";
+        return 1;
+    }
+
+    //a larger document after a small one, and a failed parse in between
+    document d;
+    d.setReuseMemory(true);
+    std::string large = "<list>";
+    for(std::size_t i = 0; i < 20000; ++i){
+        large += "<entry n=\"" + std::to_string(i) + "\">value " + std::to_string(i) + "</entry>";
+    }
+    large += "</list>";
+    for(const std::string& xml : {message(0), large, std::string("<a><b></a>"), message(1), large}){
+        try{
+            d.parseFromString(xml, parse_engine::direct);
+        }catch(const std::runtime_error&){
+            if(xml != "<a><b></a>"){
+                std::cout << "A valid document failed after reuse\n";
+                return 1;
+            }
+            continue;
+        }
+        document expected;
+        expected.parseFromString(xml, parse_engine::direct);
+        if(d.rootNode().toString() != expected.rootNode().toString()){
+            std::cout << "A document of a different size parsed into reused memory doesn't match\n";
+            return 1;
+        }
+    }
+
+    std::cout << "Reused documents parse without allocating\n";
+    return 0;
+}
\ No newline at end of file
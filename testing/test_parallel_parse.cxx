@@ -0,0 +1,56 @@
+#include <iostream>
+#include <string>
+#include "..\include\miniXML\document.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+//markup that contains '<' where a split point may land: comments, CDATA and quoted values
+std::string generate(const std::size_t records){
+    std::string xml = "<?xml version='1.0'?>\n<catalog>\n";
+    for(std::size_t i = 0; i < records; ++i){
+        const std::string n = std::to_string(i);
+        xml += "  <item id=\"" + n + "\" note='a<b " + n + "'>\n";
+        xml += "    <name>Item   number " + n + "</name>\n";
+        xml += "    <!-- <name>old " + n + "</name> -->\n";
+        xml += "    <data><![CDATA[<raw>" + n + "</raw>]]></data>\n";
+        xml += "    <empty/>\n  </item>\n";
+        if(i % 5000 == 0){
+            xml += "<!--" + std::string(200000, '<') + "-->\n";//larger than a chunk
+        }
+    }
+    return xml + "</catalog>\n";
+}
+
+int main(){
+    const std::string xml = generate(10000);
+    document expected;
+    expected.parseFromString(xml, parse_engine::direct);
+    const std::string reference = expected.rootNode().toString();
+
+    for(std::size_t threads = 1; threads <= 8; ++threads){
+        thread_pool pool(threads);
+        document d;
+        d.setThreadPool(&pool);
+        d.parseFromString(xml, parse_engine::parallel);
+        if(d.rootNode().toString() != reference){
+            std::cout << "Parsing with " << threads << " threads produced a different tree\n";
+            return 1;
+        }
+    }
+
+    //an error in any range is reported
+    thread_pool pool(4);
+    std::string broken = xml;
+    broken.replace(broken.rfind("</name>\n    <!--"), 7, "</nope>");
+    try{
+        document d;
+        d.setThreadPool(&pool);
+        d.parseFromString(broken, parse_engine::parallel);
+        std::cout << "A mismatched closing tag wasn't reported\n";
+        return 1;
+    }catch(const std::runtime_error&){}
+
+    std::cout << "Parallel parsing matches the direct engine\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "..\include\miniXML\document.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+// Documents over the size the parallel writer starts at, in shapes that split differently.
+std::string wide(){
+    std::string s = "<?xml version=\"1.0\"?><!-- wide --><catalog>";
+    for(int i = 0; i < 5000; ++i){
+        const std::string n = std::to_string(i);
+        s += "<item id=\"" + n + "\" note=\"a &lt; b &quot;" + n + "&quot;\"><name>item &amp; " + n + "</name><!--c" + n + "--><?pi " + n + "?></item>";
+    }
+    return s + "</catalog>";
+}
+std::string nested(){
+    std::string s;
+    for(int i = 0; i < 300; ++i){
+        s += "<level depth=\"" + std::to_string(i) + "\">text " + std::to_string(i);
+    }
+    for(int i = 0; i < 4000; ++i){
+        s += "<leaf>" + std::string(40, 'x') + "</leaf>";
+    }
+    for(int i = 0; i < 300; ++i){
+        s += "</level>";
+    }
+    return s;
+}
+std::string siblings(){
+    std::string s;
+    for(int i = 0; i < 4000; ++i){
+        s += "<group><a>" + std::to_string(i) + "</a><b/><c x=\"1\">" + std::string(30, 'y') + "</c></group>";
+    }
+    return "<root>" + s + "</root>";
+}
+
+std::string readFile(const std::string& path){
+    std::ifstream f(path, std::ios::binary);
+    std::stringstream s;
+    s << f.rdbuf();
+    return s.str();
+}
+
+int main(){
+    for(const auto& xml : {wide(), nested(), siblings()}){
+        document d;
+        d.parseFromString(xml, parse_engine::direct);
+        for(std::size_t threads = 1; threads <= 4; ++threads){
+            thread_pool pool(threads);
+            d.setThreadPool(&pool);
+            for(const auto format : {output_format::indented, output_format::compact}){
+                for(const int depth : {0, 3}){
+                    const std::string serial = d.rootNode().toString(depth, format);
+                    if(d.toString(depth, format) != serial){
+                        std::cout << "The parallel output differs from the serial one with " << threads << " threads\n";
+                        return 1;
+                    }
+                    d.writeToFile("parallel.xml", depth, format);
+                    if(readFile("parallel.xml") != serial){
+                        std::cout << "The written file differs from the serial output with " << threads << " threads\n";
+                        return 1;
+                    }
+                }
+            }
+        }
+        //the document still reads back the same after the parallel write
+        document again;
+        again.parseFromString(readFile("parallel.xml"), parse_engine::direct);
+        if(again.rootNode().toString() != d.rootNode().toString()){
+            std::cout << "The written file doesn't parse back to the same tree\n";
+            return 1;
+        }
+    }
+
+    //lazily parsed and small documents take the serial path and write the same
+    thread_pool pool(4);
+    document lazy;
+    lazy.setThreadPool(&pool);
+    lazy.parseFromString(wide(), parse_engine::lazy);
+    document small;
+    small.setThreadPool(&pool);
+    small.parseFromString("<a><b>x</b></a>", parse_engine::direct);
+    document built;
+    built.rootNode().appendChild(std::make_unique<node>(node_type::ELEMENT_NODE, "empty"));
+    for(const document* d : {&lazy, &small, &built}){
+        if(d->toString() != d->rootNode().toString()){
+            std::cout << "A document written serially differs\n";
+            return 1;
+        }
+    }
+
+    //trees built or grown through the API are written on the pool by their size, not by the size of what was parsed
+    document api;
+    node* list = api.rootNode().appendChild(std::make_unique<node>(node_type::ELEMENT_NODE, "list"));
+    document grown;
+    grown.parseFromString("<list><entry>0</entry></list>", parse_engine::direct);
+    for(node* target : {list, grown.rootNode().getChildren().front().get()}){
+        for(int i = 0; i < 5000; ++i){
+            node* entry = target->appendChild(std::make_unique<node>(node_type::ELEMENT_NODE, "entry"));
+            entry->appendAttribute("id", std::to_string(i));
+            entry->appendChild(std::make_unique<node>(node_type::TEXT_NODE, "value &amp; " + std::to_string(i)));
+        }
+    }
+    for(document* d : {&api, &grown}){
+        d->setThreadPool(&pool);
+        if(!outputReaches(d->rootNode(), 128 * 1024)){
+            std::cout << "A large tree built through the API is taken for a small one\n";
+            return 1;
+        }
+        const std::string serial = d->rootNode().toString();
+        d->writeToFile("parallel.xml");
+        if(d->toString() != serial || readFile("parallel.xml") != serial){
+            std::cout << "A tree built through the API is written differently in parallel\n";
+            return 1;
+        }
+    }
+    //documents written from a task of their own pool are written serially instead of waiting for the pool
+    std::vector<std::string> fromTasks(3);
+    pool.parallelFor(fromTasks.size(), [&](const std::size_t i){
+        if(i == 0){
+            fromTasks[i] = api.toString();
+            (void)api.computeHashes();// hashing modifies the tree, so only this task touches it
+        }else{
+            fromTasks[i] = grown.toString();
+        }
+    });
+    if(fromTasks[0] != api.rootNode().toString() || fromTasks[1] != grown.rootNode().toString() || fromTasks[2] != fromTasks[1]){
+        std::cout << "A document written from a task of its pool differs\n";
+        return 1;
+    }
+    if(outputReaches(small.rootNode(), 128 * 1024)){
+        std::cout << "A small tree is taken for a large one\n";
+        return 1;
+    }
+    std::remove("parallel.xml");
+
+    std::cout << "Parallel writes match the serial writer\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#include <iostream>
+#include "..\include\miniXML\document.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+int main(){
+    //parse the same file with every engine, the lazy one expands its nodes as the writer walks them
+    document tokenized("file.xml", parse_engine::tokens);
+    const std::string expected = tokenized.rootNode().toString();
+    std::cout << expected;
+    for(const auto engine : {parse_engine::direct, parse_engine::parallel, parse_engine::lazy}){
+        document d("file.xml", engine);
+        if(d.rootNode().toString() != expected){
+            std::cout << "The engines produced different trees\n";
+            return 1;
+        }
+    }
+    std::cout << "All engines produced the same tree\n";
+    return 0;
+}
\ No newline at end of file
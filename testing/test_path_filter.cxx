@@ -0,0 +1,72 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "..\include\miniXML\path_filter.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+int main(){
+    std::string xml = "<?xml version='1.0'?><feed><title>Feed</title>";
+    for(int i = 0; i < 1000; ++i){
+        xml += "<entry id='" + std::to_string(i) + "'><!-- entry --><title>Entry " + std::to_string(i) + "</title><entry id='inner'/></entry>";
+    }
+    xml += "<meta><link href='x'/></meta></feed>";
+
+    //every record matches the same subtree of the whole document
+    document whole;
+    whole.parseFromString(xml, parse_engine::direct);
+    const query entries("/feed/entry");
+    std::vector<std::string> expected;
+    for(const node* n : entries.select(whole.rootNode())){
+        expected.push_back(n->toString());
+    }
+
+    std::size_t records = 0, links = 0;
+    bool same = true;
+    path_filter filter;
+    filter.match("/feed/entry", [&](node& record, std::size_t pattern){
+        same = same && pattern == 0 && records < expected.size() && record.toString() == expected[records];
+        ++records;
+    });
+    filter.match("//link", [&](node& record, std::size_t pattern){
+        same = same && pattern == 1 && record.getAttribute("href") == "x";
+        ++links;
+    });
+    std::istringstream in(xml);
+    reader r(in, 256);
+    filter.run(r);
+    if(!same || records != expected.size() || links != 1){
+        std::cout << "The records don't match the document\n";
+        return 1;
+    }
+
+    //in push mode records can span several chunks
+    path_filter pushed;
+    records = 0;
+    pushed.match("/feed/*", [&](node& record, std::size_t){
+        records += record.getValue() == "entry";
+    });
+    reader chunks;
+    for(std::size_t i = 0; i < xml.size(); i += 7){
+        chunks.feed(std::string_view(xml).substr(i, 7));
+        pushed.run(chunks);
+    }
+    chunks.finish();
+    pushed.run(chunks);
+    if(records != expected.size()){
+        std::cout << "Records fed in chunks were lost\n";
+        return 1;
+    }
+
+    for(const char* bad : {"feed/entry", "/feed/entry[1]", "/feed/text()"}){
+        try{
+            path_filter f;
+            f.match(bad, [](node&, std::size_t){});
+            std::cout << "The invalid pattern " << bad << " was accepted\n";
+            return 1;
+        }catch(const std::runtime_error&){}
+    }
+    std::cout << "The path filter extracts the matching records\n";
+    return 0;
+}
\ No newline at end of file
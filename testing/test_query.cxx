@@ -0,0 +1,89 @@
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "..\include\miniXML\query.hpp"
+#include "..\include\miniXML\document.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+//ranges can only be taken from a query that outlives them, a temporary one selects a deleted overload
+template<class Query, class Node, class = void>
+struct can_select : std::false_type{};
+template<class Query, class Node>
+struct can_select<Query, Node, std::void_t<decltype(std::declval<Query>().select(std::declval<Node&>()))>> : std::true_type{};
+static_assert(can_select<query&, node>::value && can_select<const query&, const node>::value);
+static_assert(!can_select<query, node>::value && !can_select<query, const node>::value);
+static_assert(!can_select<const query, node>::value && !can_select<const query, const node>::value);
+
+//values of the nodes a query selects, text nodes by their text and elements by their id attribute
+std::string evaluate(const std::string& path, const node& context){
+    std::string out;
+    const query q(path);
+    for(const node* n : q.select(context)){
+        if(!out.empty()){
+            out += ",";
+        }
+        out += n->getType() == node_type::TEXT_NODE ? std::string(n->getValue()) : std::string(n->getAttribute("id").value_or(n->getValue()));
+    }
+    return out;
+}
+
+int main(){
+    document d;
+    d.parseFromString(
+        "<catalog>"
+        "<item id='a' kind='book'><name>First</name></item>"
+        "<item id='b'><name>Second</name><item id='b1' kind='book'><name>Nested</name></item></item>"
+        "<group id='g'><item id='c' kind='book'><name>Third</name></item><item id='d'/><item id='e' kind='book'/></group>"
+        "</catalog>", parse_engine::direct);
+    const node& root = d.rootNode();
+
+    const std::vector<std::pair<std::string, std::string>> cases = {
+        {"/catalog/item", "a,b"},
+        {"//item", "a,b,b1,c,d,e"},
+        {"//item[@kind='book']", "a,b1,c,e"},
+        {"//item[@kind]/name/text()", "First,Nested,Third"},
+        {"/catalog/item[2]", "b"},
+        {"//item[1]", "a,b1,c"},
+        {"//item[@kind='book'][2]", "e"},
+        {"//item[2][@kind='book']", ""},
+        {"/catalog/*", "a,b,g"},
+        {"//group//name/text()", "Third"},
+        {"//item//item", "b1"},
+        {"/catalog/item[@id=\"b\"]//text()", "Second,Nested"},
+        {"/nothing", ""},
+    };
+    for(const auto& [path, expected] : cases){
+        const std::string result = evaluate(path, root);
+        if(result != expected){
+            std::cout << path << " selected " << result << " instead of " << expected << "\n";
+            return 1;
+        }
+    }
+
+    //relative queries start at the context node, absolute ones at its document
+    const node* group = query("//group").first(root);
+    if(!group || evaluate("item", *group) != "c,d,e" || evaluate(".//name/text()", *group) != "Third" || evaluate("/catalog/item[1]", *group) != "a"){
+        std::cout << "Relative queries don't start at the context\n";
+        return 1;
+    }
+    //a compiled query can be evaluated many times
+    const query names("//name");
+    if(names.count(root) != 4 || names.count(*group) != 4 || names.count(root) != 4){
+        std::cout << "Evaluating a query again gave a different result\n";
+        return 1;
+    }
+
+    for(const char* bad : {"", "/", "/a[", "/a[0]", "/a[@id='x]", "/a/text()/b", "/a[1][2]"}){
+        try{
+            query q(bad);
+            std::cout << "The invalid query " << bad << " was accepted\n";
+            return 1;
+        }catch(const std::runtime_error&){}
+    }
+    std::cout << "Queries select the expected nodes\n";
+    return 0;
+}
\ No newline at end of file
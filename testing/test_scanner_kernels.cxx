@@ -0,0 +1,49 @@
+#include <iostream>
+#include <random>
+#include "..\include\miniXML\document.hpp"
+
+using namespace miniXML::details;
+
+//runs every kernel on the same input and compares the result with the scalar one
+template<const byte_set& Set>
+bool compareLevels(const std::string& input){
+    const simd_level detected = simdLevel();
+    for(std::size_t from = 0; from <= input.size(); ++from){
+        simdLevel() = simd_level::scalar;
+        const auto expectedFirst = findFirstOf<Set>(input, from);
+        const auto expectedNot = findFirstNotOf<Set>(input, from);
+        for(const auto level : {simd_level::sse2, simd_level::avx2}){
+            if(level > detected){
+                continue;
+            }
+            simdLevel() = level;
+            if(findFirstOf<Set>(input, from) != expectedFirst || findFirstNotOf<Set>(input, from) != expectedNot){
+                simdLevel() = detected;
+                return false;
+            }
+        }
+    }
+    simdLevel() = detected;
+    return true;
+}
+
+int main(){
+    std::mt19937 random(42);
+    const std::string alphabet = "abc<>=/?-\"'& \t\n\r\v\f";
+    for(int run = 0; run < 200; ++run){
+        std::string input(random() % 300, 'x');
+        for(auto& c : input){
+            //mostly plain text, so the kernels have to skip long runs
+            if(random() % 8 == 0){
+                c = alphabet[random() % alphabet.size()];
+            }
+        }
+        if(!compareLevels<whitespace_set>(input) || !compareLevels<identifier_end_set>(input) || !compareLevels<tag_delimiter_set>(input)
+            || !compareLevels<reference_set>(input) || !compareLevels<attribute_escape_set>(input)){
+            std::cout << "Kernel mismatch on: " << input << '\n';
+            return 1;
+        }
+    }
+    std::cout << "All kernels agree\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "..\include\miniXML\compact_document.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+bool rejected(const std::string& filepath){
+    try{
+        compact_document c;
+        c.load(filepath);
+    }catch(const std::runtime_error&){
+        return true;
+    }
+    return false;
+}
+
+int main(){
+    document original("file.xml", parse_engine::direct);
+    const std::string expected = original.rootNode().toString();
+    compact_document(original.rootNode()).save("file.snapshot");
+
+    //the snapshot is used in place when mapped, and read into memory otherwise
+    for(const auto mode : {load_mode::map, load_mode::read, load_mode::map_populate}){
+        compact_document loaded;
+        loaded.load("file.snapshot", mode);
+        document rebuilt;
+        loaded.toDocument(rebuilt);
+        if(rebuilt.rootNode().toString() != expected){
+            std::cout << "The snapshot didn't load back into the same tree\n";
+            return 1;
+        }
+        const auto from = loaded.select(query("/note/from"));
+        if(from.size() != 1 || loaded.getAttribute(from[0], "id") != "Bob" || loaded.getSymbol(from[0]) != loaded.findSymbol("from").id){
+            std::cout << "The loaded snapshot can't be queried\n";
+            return 1;
+        }
+        //a loaded snapshot can be saved again and parsed over
+        loaded.save("copy.snapshot");
+        loaded.parseFromString("<a/>");
+        if(loaded.size() != 2 || loaded.getValue(1) != "a"){
+            std::cout << "A loaded snapshot couldn't be replaced\n";
+            return 1;
+        }
+    }
+    std::ifstream first("file.snapshot", std::ios::binary), second("copy.snapshot", std::ios::binary);
+    const std::string bytes{std::istreambuf_iterator<char>(first), std::istreambuf_iterator<char>()};
+    if(bytes != std::string{std::istreambuf_iterator<char>(second), std::istreambuf_iterator<char>()}){
+        std::cout << "Saving a loaded snapshot changed it\n";
+        return 1;
+    }
+
+    //files that aren't complete snapshots are refused
+    std::ofstream("bad.snapshot", std::ios::binary) << "<note>not a snapshot</note>";
+    if(!rejected("bad.snapshot")){
+        std::cout << "An XML file was loaded as a snapshot\n";
+        return 1;
+    }
+    std::ofstream("bad.snapshot", std::ios::binary) << bytes.substr(0, bytes.size() / 2);
+    if(!rejected("bad.snapshot")){
+        std::cout << "A truncated snapshot was loaded\n";
+        return 1;
+    }
+    //so are snapshots whose indices or text ranges point outside of the arrays
+    const std::size_t nodes = compact_document(original.rootNode()).size();
+    auto pad = [](const std::size_t size){
+        return (size + 7) / 8 * 8;
+    };
+    const std::size_t words = pad(nodes * 4);
+    const std::size_t nameIds = 56 + pad(nodes), valueLengths = nameIds + 2 * words, parents = nameIds + 5 * words;
+    const std::size_t attributeNames = nameIds + 6 * words + pad((nodes + 1) * 4);
+    auto corrupted = [&bytes](const std::size_t at, const std::uint32_t value){
+        std::string copy = bytes;
+        std::memcpy(copy.data() + at, &value, sizeof(value));
+        std::ofstream("bad.snapshot", std::ios::binary) << copy;
+        return rejected("bad.snapshot");
+    };
+    if(!corrupted(nameIds + 4, 100000) || !corrupted(valueLengths + 4 * (nodes - 1), 0xFFFFFFFF)
+        || !corrupted(parents + 4 * (nodes - 1), static_cast<std::uint32_t>(nodes - 1)) || !corrupted(parents + 4, 5)
+        || !corrupted(attributeNames, 0) || !corrupted(attributeNames, 100000)){
+        std::cout << "A snapshot with broken indices was loaded\n";
+        return 1;
+    }
+    if(corrupted(0, *reinterpret_cast<const std::uint32_t*>(bytes.data()))){
+        std::cout << "An intact copy of the snapshot was refused\n";
+        return 1;
+    }
+    for(const char* f : {"file.snapshot", "copy.snapshot", "bad.snapshot"}){
+        std::remove(f);
+    }
+    std::cout << "Snapshots load back into the same document\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include "..\include\miniXML\document.hpp"
+#include "..\include\miniXML\reader.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+//rebuilds a tree from the events, to compare it with the tree of a document
+class tree_builder{
+    public:
+        explicit tree_builder(document& d) : current(&d.rootNode()){}
+        void operator()(const event& e){
+            switch (e.type){
+                case event_type::start_element:
+                    current = current->appendChild(std::make_unique<node>(node_type::ELEMENT_NODE, e.name));
+                    break;
+                case event_type::attribute:
+                    current->appendAttribute(e.name, e.value);
+                    break;
+                case event_type::end_element:
+                    current = current->getParent();
+                    break;
+                case event_type::text:
+                    current->appendChild(std::make_unique<node>(node_type::TEXT_NODE, e.value));
+                    break;
+                case event_type::comment:
+                    current->appendChild(std::make_unique<node>(node_type::COMMENT_NODE, e.value));
+                    break;
+                case event_type::processing_instruction:
+                    current->appendChild(std::make_unique<node>(node_type::PROCESSING_INSTRUCTION_NODE, e.value));
+                    break;
+            }
+        }
+    private:
+        node* current;
+};
+
+int main(){
+    document expected("file.xml", parse_engine::direct);
+    const std::string xml = expected.rootNode().toString();
+
+    //pull mode, with a buffer small enough to split every markup
+    std::ifstream file("file.xml", std::ios::binary);
+    reader pull(file, 7);
+    document pulled;
+    pull.parse(tree_builder(pulled));
+
+    //push mode, one byte at a time
+    std::ifstream again("file.xml", std::ios::binary);
+    const std::string content((std::istreambuf_iterator<char>(again)), std::istreambuf_iterator<char>());
+    reader push;
+    document pushed;
+    tree_builder builder(pushed);
+    event e;
+    for(const char c : content){
+        push.feed(std::string_view(&c, 1));
+        while(push.next(e)){
+            builder(e);
+        }
+    }
+    push.finish();
+    while(push.next(e)){
+        builder(e);
+    }
+
+    std::cout << pulled.rootNode().toString();
+    if(pulled.rootNode().toString() != xml || pushed.rootNode().toString() != xml || !push.done()){
+        std::cout << "The streamed events don't match the document\n";
+        return 1;
+    }
+
+    //large markups read through short reads, every byte is searched once however many reads it takes
+    const std::string big = "<a><!--" + std::string(4 << 20, 'c') + "--><b v='" + std::string(1 << 20, '\"') + "'>" + std::string(4 << 20, 't') + "</b></a>";
+    std::size_t offset = 0;
+    reader shortReads([&](char* b, const std::size_t n){
+        const std::size_t count = std::min<std::size_t>({n, 4096, big.size() - offset});
+        std::copy(big.data() + offset, big.data() + offset + count, b);
+        offset += count;
+        return count;
+    }, 4096);
+    std::size_t sizes = 0;
+    while(shortReads.next(e)){
+        sizes += e.value.size();
+    }
+    if(sizes != (4u << 20) + (1u << 20) + (4u << 20) || !shortReads.done()){
+        std::cout << "Large markups read in short reads weren't reported whole\n";
+        return 1;
+    }
+    std::cout << "The streamed events match the document\n";
+    return 0;
+}
\ No newline at end of file
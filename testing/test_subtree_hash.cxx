@@ -0,0 +1,147 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "..\include\miniXML\document.hpp"
+#include "..\include\miniXML\diff.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+const std::string config =
+    "<config version=\"3\">\n"
+    "  <server host=\"alpha\" port=\"80\"><timeout>30</timeout></server>\n"
+    "  <server host=\"beta\" port=\"81\"><timeout>30</timeout></server>\n"
+    "  <!-- logging -->\n"
+    "  <log level=\"info\"/>\n"
+    "</config>\n";
+
+std::string generated(const std::size_t items){
+    std::string s = "<catalog>";
+    for(std::size_t i = 0; i < items; ++i){
+        const std::string n = std::to_string(i);
+        s += "<item id=\"" + n + "\"><name>item " + n + "</name><price>" + std::to_string(i % 97) + "</price></item>";
+    }
+    return s + "</catalog>";
+}
+
+bool describes(const std::vector<node_change>& changes, const std::size_t i, const change_type t, const std::string_view value){
+    if(i >= changes.size() || changes[i].type != t){
+        return false;
+    }
+    const node* n = t == change_type::removed ? changes[i].before : changes[i].after;
+    return n && n->getValue() == value;
+}
+
+int main(){
+    //equal trees hash equal with every engine, hashes don't depend on how the tree was parsed
+    std::vector<std::unique_ptr<document>> parsed;
+    for(const auto engine : {parse_engine::tokens, parse_engine::direct, parse_engine::parallel, parse_engine::lazy}){
+        parsed.push_back(std::make_unique<document>());
+        parsed.back()->parseFromString(config, engine);
+    }
+    const std::uint64_t expected = parsed[1]->rootNode().getHash();
+    for(const auto& d : parsed){
+        if(d->computeHashes() != expected){
+            std::cout << "Equal documents hash differently\n";
+            return 1;
+        }
+    }
+
+    //every modifier clears the hashes up to the root, and the old content hashes the same again
+    document d;
+    d.parseFromString(config, parse_engine::direct);
+    node& root = d.rootNode();
+    node* timeout = root.findChild("config")->findChild("server")->findChild(node_type::ELEMENT_NODE)->getChildren()[0].get();
+    timeout->setValue("60");
+    if(root.getHash() == expected){
+        std::cout << "setValue() didn't change the hash of the root\n";
+        return 1;
+    }
+    timeout->setValue("30");
+    if(root.getHash() != expected){
+        std::cout << "Restoring a value didn't restore the hash\n";
+        return 1;
+    }
+    node* log = root.findChild("config")->findChild("log");
+    log->appendAttribute("level", "debug");
+    const std::uint64_t debug = root.getHash();
+    if(debug == expected || !log->deleteAttribute("level") || root.getHash() == debug){
+        std::cout << "Attribute changes didn't change the hash\n";
+        return 1;
+    }
+    log->appendAttribute("level", "info");
+    node* added = log->appendChild(std::make_unique<node>(node_type::TEXT_NODE, "x"));
+    if(root.getHash() == expected || !log->deleteChild(added) || root.getHash() != expected){
+        std::cout << "Adding and deleting a child didn't change the hash back and forth\n";
+        return 1;
+    }
+
+    //the same values in a different structure hash differently
+    document swapped;
+    swapped.parseFromString("<a><b/>x</a>", parse_engine::direct);
+    document other;
+    other.parseFromString("<a>x<b/></a>", parse_engine::direct);
+    document attr;
+    attr.parseFromString("<a b=\"x\"/>", parse_engine::direct);
+    document text;
+    text.parseFromString("<a>bx</a>", parse_engine::direct);
+    if(swapped.computeHashes() == other.computeHashes() || attr.computeHashes() == text.computeHashes()){
+        std::cout << "Different trees hash equal\n";
+        return 1;
+    }
+
+    //a diff lists what changed, in document order
+    document before;
+    before.parseFromString(config, parse_engine::direct);
+    document after;
+    after.parseFromString(
+        "<config version=\"4\">\n"
+        "  <server host=\"alpha\" port=\"80\"><timeout>45</timeout></server>\n"
+        "  <server host=\"gamma\" port=\"82\"><timeout>30</timeout></server>\n"
+        "  <server host=\"beta\" port=\"81\"><timeout>30</timeout></server>\n"
+        "  <log level=\"info\"/>\n"
+        "</config>\n", parse_engine::direct);
+    auto changes = diff(before.rootNode(), after.rootNode());
+    if(changes.size() != 4
+        || !describes(changes, 0, change_type::modified, "config") || changes[0].before->getAttribute("version") != "3"
+        || !describes(changes, 1, change_type::modified, "45") || changes[1].before->getValue() != "30"
+        || !describes(changes, 2, change_type::added, "server") || changes[2].after->getAttribute("host") != "gamma"
+        || !describes(changes, 3, change_type::removed, "logging")
+        || changes[3].before->getType() != node_type::COMMENT_NODE){
+        std::cout << "The diff of two versions is wrong, " << changes.size() << " changes\n";
+        return 1;
+    }
+    if(!diff(before.rootNode(), before.rootNode()).empty() || !diff(parsed[0]->rootNode(), before.rootNode()).empty()){
+        std::cout << "Equal trees have a diff\n";
+        return 1;
+    }
+
+    //a large tree is hashed on the pool, the result is the one of the serial walk
+    const std::string catalog = generated(20000);
+    thread_pool pool(4);
+    document big;
+    big.setThreadPool(&pool);
+    big.parseFromString(catalog, parse_engine::parallel);
+    document serial;
+    serial.parseFromString(catalog, parse_engine::direct);
+    const std::uint64_t whole = big.computeHashes();
+    if(whole != serial.rootNode().getHash()){
+        std::cout << "The parallel hash differs from the serial one\n";
+        return 1;
+    }
+    node* item = big.rootNode().findChild("catalog")->getChildren()[12345].get();
+    item->findChild("price")->getChildren()[0]->setValue("1000");
+    if(big.computeHashes() == whole){
+        std::cout << "A change deep in a large tree didn't change its hash\n";
+        return 1;
+    }
+    changes = diff(serial.rootNode(), big.rootNode());
+    if(changes.size() != 1 || !describes(changes, 0, change_type::modified, "1000")){
+        std::cout << "The diff of a large tree is wrong\n";
+        return 1;
+    }
+
+    std::cout << "Subtree hashes follow the tree\n";
+    return 0;
+}
\ No newline at end of file
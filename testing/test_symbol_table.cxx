@@ -0,0 +1,71 @@
+#include <iostream>
+#include <string>
+#include "..\include\miniXML\document.hpp"
+
+using namespace miniXML;
+using namespace miniXML::details;
+
+//every element named item, below the catalog element
+bool sameSymbols(document& d){
+    const symbol item = d.findSymbol("item");
+    const node* catalog = d.rootNode().findChild(d.findSymbol("catalog"));
+    if(item.id == no_symbol || !catalog){
+        return false;
+    }
+    const auto items = catalog->findChildren(item);
+    if(items.size() != catalog->findChildren(std::string_view("item")).size()){
+        return false;
+    }
+    for(const node* n : items){
+        if(n->getType() != node_type::ELEMENT_NODE){
+            continue;//the comments have the same value
+        }
+        //one stored copy of the name, and of the attribute key
+        if(n->getSymbol() != item.id || n->getValue().data() != item.name.data()){
+            return false;
+        }
+        for(const auto& a : n->getAttributes()){
+            if(a.first.data() != d.findSymbol("id").name.data()){
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(){
+    std::string xml = "<catalog>";
+    for(int i = 0; i < 20000; ++i){
+        xml += "<item id='" + std::to_string(i) + "'><name>n</name></item><!-- item -->";
+    }
+    xml += "</catalog>";
+
+    for(const auto engine : {parse_engine::tokens, parse_engine::direct, parse_engine::parallel}){
+        thread_pool pool(4);
+        document d;
+        d.setThreadPool(&pool);
+        d.parseFromString(xml, engine);
+        if(!sameSymbols(d) || d.symbols().size() != 4){
+            std::cout << "Names weren't interned by engine " << static_cast<int>(engine) << "\n";
+            return 1;
+        }
+    }
+
+    document d;
+    d.parseFromString("<note><to>Alice</to><from>Bob</from></note>", parse_engine::direct);
+    node* note = d.rootNode().findChild(d.findSymbol("note"));
+    //nodes added through the API have no symbol and are matched by value
+    node* added = note->appendChild(std::make_unique<node>(node_type::ELEMENT_NODE, "cc"));
+    if(note->findChild(d.findSymbol("cc")) != added || d.findSymbol("cc").id != no_symbol){
+        std::cout << "A node without a symbol wasn't found by value\n";
+        return 1;
+    }
+    node* to = note->findChild(d.findSymbol("to"));
+    to->setValue("bcc");
+    if(to->getSymbol() != no_symbol || note->findChild(d.findSymbol("to")) || note->findChild(d.findSymbol("bcc")) != to){
+        std::cout << "A renamed node kept its symbol\n";
+        return 1;
+    }
+    std::cout << "Names are interned\n";
+    return 0;
+}
\ No newline at end of file